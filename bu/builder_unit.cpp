@@ -1,4 +1,5 @@
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <algorithm>
 #include <thread>
@@ -15,17 +16,18 @@ namespace lseb {
 
 namespace {
 
-int find_endpoint_id(
-  std::vector<Endpoint> const& endpoints,
-  std::string const& address) {
-  auto it = std::find_if(
-    std::begin(endpoints),
-    std::end(endpoints),
-    [&address](Endpoint const& ep) {return ep.hostname() == address;});
-  return
-      (it == std::end(endpoints)) ?
-        -1 :
-        std::distance(std::begin(endpoints), it);
+// Start of the event following the one at p in a transfer ending at end. A
+// short or corrupt transfer would walk off the receive buffer.
+unsigned char* next_event(unsigned char* p, unsigned char* end) {
+  if (static_cast<size_t>(end - p) < sizeof(EventHeader)) {
+    throw std::runtime_error("Truncated event header in transfer");
+  }
+  uint64_t const length = pointer_cast<EventHeader>(p)->length;
+  if (length < sizeof(EventHeader) || length > static_cast<size_t>(end - p)) {
+    throw std::runtime_error(
+      "Wrong event length in transfer: " + std::to_string(length));
+  }
+  return p + length;
 }
 
 }
@@ -34,48 +36,192 @@ BuilderUnit::BuilderUnit(
   boost::lockfree::spsc_queue<iovec>& free_local_data,
   boost::lockfree::spsc_queue<iovec>& ready_local_data,
   std::vector<Endpoint> const& endpoints,
+  RoutingTable const& routing_table,
+  TcpOptions const& tcp_options,
   int bulk_size,
+  size_t bulked_bytes,
+  bool variable_bulk,
   int credits,
   int max_fragment_size,
+  size_t recv_ring_size,
+  int coalesce,
+  ControlClient* control,
+  CongestionMonitor const& monitor,
+  ControlClient* feedback,
   int id)
     :
       m_free_local_queue(free_local_data),
       m_ready_local_queue(ready_local_data),
       m_endpoints(endpoints),
+      m_routing_table(routing_table),
+      m_tcp_options(tcp_options),
+      m_connection_ids(endpoints.size()),
       m_data_vect(endpoints.size()),
+      m_transfers(endpoints.size()),
+      m_partial(endpoints.size(), std::make_pair(iovec { nullptr, 0 }, 0)),
+      m_ready_set(endpoints.size()),
+      m_polled_ids(1, id),
       m_bulk_size(bulk_size),
+      m_bulked_bytes(bulked_bytes),
+      m_variable_bulk(variable_bulk),
       m_credits(credits),
       m_max_fragment_size(max_fragment_size),
+      m_recv_ring_size(recv_ring_size),
+      m_coalesce(coalesce),
+      m_control(control),
+      m_monitor(monitor),
+      m_feedback(feedback),
       m_id(id) {
 }
 
+// A receive ring is used when requested and supported by the transport,
+// otherwise fixed chunks of the maximum size are posted
+bool BuilderUnit::ring_mode(int id) {
+  return m_recv_ring_size && supports_recv_ring(m_routing_table.route(id));
+}
+
+// A transfer holds up to m_coalesce multievents, or a piece of one of them
+// with a byte budget
+size_t BuilderUnit::chunk_size() {
+  return m_bulked_bytes ?
+    m_bulked_bytes : m_max_fragment_size * m_bulk_size * m_coalesce;
+}
+
+size_t BuilderUnit::memory_size(int id) {
+  return ring_mode(id) ? m_recv_ring_size : chunk_size() * m_credits;
+}
+
+// The multievents of a transfer are found from the lengths in the headers of
+// their m_bulk_size events. With a byte budget, a transfer is a piece of a
+// multievent instead: the multievent is complete with its m_bulk_size-th
+// event, and only the transfer that completes it counts. It is handed over as
+// its first piece, the only one whose header is checked: the pieces are not
+// contiguous and are given back with their transfers.
+int BuilderUnit::split_transfer(
+  int id,
+  iovec const& transfer,
+  std::vector<iovec>& iov_vect) {
+  if (m_bulked_bytes) {
+    auto& partial = m_partial[id];
+    unsigned char* p = static_cast<unsigned char*>(transfer.iov_base);
+    unsigned char* const end = p + transfer.iov_len;
+    if (!partial.second) {
+      partial.first = transfer;
+    }
+    while (p != end) {
+      if (partial.second == m_bulk_size) {
+        throw std::runtime_error("Too many events in multievent piece");
+      }
+      p = next_event(p, end);
+      ++partial.second;
+    }
+    if (partial.second != m_bulk_size) {
+      return 0;
+    }
+    iov_vect.push_back(partial.first);
+    partial.second = 0;
+    return 1;
+  }
+  if (m_coalesce == 1) {
+    iov_vect.push_back(transfer);
+    return 1;
+  }
+  unsigned char* p = static_cast<unsigned char*>(transfer.iov_base);
+  unsigned char* const end = p + transfer.iov_len;
+  int multievents = 0;
+  while (p != end) {
+    unsigned char* const begin = p;
+    for (int i = 0; i < m_bulk_size; ++i) {
+      p = next_event(p, end);
+    }
+    iov_vect.push_back( { begin, static_cast<size_t>(p - begin) });
+    ++multievents;
+  }
+  return multievents;
+}
+
 int BuilderUnit::read_data(int id) {
   auto& iov_vect = m_data_vect[id];
   int const old_size = iov_vect.size();
   if (id != m_id) {
-    auto& conn = *(m_connection_ids.at(id));
-    std::vector<iovec> new_data = conn.pop_completed();
-    if (!new_data.empty()) {
-      iov_vect.insert(
-        std::end(iov_vect),
-        std::begin(new_data),
-        std::end(new_data));
+    auto& conn = *(m_connection_ids[id]);
+    std::vector<iovec> const transfers = conn.pop_completed();
+    for (auto const& transfer : transfers) {
+      m_transfers[id].emplace_back(transfer, split_transfer(id, transfer, iov_vect));
+    }
+    if (m_monitor.enabled() && !ring_mode(id) && !transfers.empty()) {
+      m_monitor.filled(
+        id,
+        transfers.size(),
+        CongestionMonitor::Clock::now());
     }
   } else {
-    iovec iov;
-    while (m_ready_local_queue.pop(iov)) {
-      iov_vect.push_back(iov);
+    iovec transfer;
+    while (m_ready_local_queue.pop(transfer)) {
+      m_transfers[id].emplace_back(transfer, split_transfer(id, transfer, iov_vect));
     }
   }
   return iov_vect.size() - old_size;
 }
 
+// Events in the first n multievents of every source. When the size of the
+// multievents varies, they are counted in the local ones (a multievent per
+// transfer).
+int BuilderUnit::built_events(int n) {
+  if (!m_variable_bulk) {
+    return n * m_bulk_size;
+  }
+  int events = 0;
+  for (int i = 0; i < n; ++i) {
+    iovec const& multievent = m_data_vect[m_id][i];
+    unsigned char* p = static_cast<unsigned char*>(multievent.iov_base);
+    unsigned char* const end = p + multievent.iov_len;
+    while (p != end) {
+      assert(p < end);
+      p += pointer_cast<EventHeader>(p)->length;
+      ++events;
+    }
+  }
+  return events;
+}
+
+int BuilderUnit::check_handshake(
+  Handshake const& handshake,
+  TransportType type) {
+  int const id = handshake.rank;
+  if (id < 0 || id >= static_cast<int>(m_endpoints.size()) || id == m_id) {
+    throw std::runtime_error(
+      "Wrong rank in handshake: " + std::to_string(id));
+  }
+  if (m_connection_ids[id]) {
+    throw std::runtime_error(
+      "Connection already present for rank " + std::to_string(id));
+  }
+  if (m_routing_table.route(id) != type) {
+    throw std::runtime_error(
+      "Rank " + std::to_string(id) + " connected with the wrong transport");
+  }
+  if (handshake.credits > static_cast<uint32_t>(m_credits)) {
+    throw std::runtime_error(
+      "Rank " + std::to_string(id) + " uses too many credits: "
+        + std::to_string(handshake.credits));
+  }
+  if (handshake.chunk_size > chunk_size()
+    || (ring_mode(id) && handshake.chunk_size > m_recv_ring_size)) {
+    throw std::runtime_error(
+      "Rank " + std::to_string(id) + " uses a too large chunk size: "
+        + std::to_string(handshake.chunk_size));
+  }
+  return id;
+}
+
 bool BuilderUnit::check_data() {
   uint64_t local_evt_id = pointer_cast<EventHeader>(
     m_data_vect[m_id].front().iov_base)->id;
   for (auto& data : m_data_vect) {
     uint64_t id = pointer_cast<EventHeader>(data.front().iov_base)->id;
-    uint64_t flags = pointer_cast<EventHeader>(data.front().iov_base)->flags;
+    uint64_t flags = pointer_cast<EventHeader>(data.front().iov_base)->flags
+      & ~rejected_event_flag;
     uint64_t length = pointer_cast<EventHeader>(data.front().iov_base)->length;
     if (id != local_evt_id) {
       LOG(ERROR)
@@ -98,21 +244,40 @@ bool BuilderUnit::check_data() {
   return true;
 }
 
+// The bytes are counted when the transfers are given back, which is once all
+// their multievents are released
 size_t BuilderUnit::release_data(int id, int n) {
   auto& iov_vect = m_data_vect[id];
-  assert(iov_vect.size() >= n);
-  std::vector<iovec> sub_vect(std::begin(iov_vect), std::begin(iov_vect) + n);
+  assert(iov_vect.size() >= static_cast<size_t>(n));
   // Erase iovec
   iov_vect.erase(std::begin(iov_vect), std::begin(iov_vect) + n);
-  size_t const bytes = iovec_length(sub_vect);
+  std::vector<iovec> sub_vect;
+  size_t bytes = 0;
+  auto& transfers = m_transfers[id];
+  while (n) {
+    auto& transfer = transfers.front();
+    int const released = std::min(n, transfer.second);
+    transfer.second -= released;
+    n -= released;
+    if (!transfer.second) {
+      sub_vect.push_back(transfer.first);
+      bytes += transfer.first.iov_len;
+      transfers.pop_front();
+    }
+  }
   // Release iovec
   if (id != m_id) {
-    auto& conn = *(m_connection_ids.at(id));
-    // Reset len of iovec
-    for (auto& iov : sub_vect) {
-      iov.iov_len = m_max_fragment_size * m_bulk_size;  // chunk size
+    auto& conn = *(m_connection_ids[id]);
+    // Reset len of iovec (the ring needs the received one)
+    if (!ring_mode(id)) {
+      for (auto& iov : sub_vect) {
+        iov.iov_len = chunk_size();
+      }
     }
     conn.post_recv(sub_vect);
+    if (m_monitor.enabled() && !ring_mode(id)) {
+      m_monitor.posted(id, sub_vect.size(), CongestionMonitor::Clock::now());
+    }
   } else {
     for (auto& iov : sub_vect) {
       while (!m_free_local_queue.push(iov)) {
@@ -129,60 +294,85 @@ void BuilderUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
 
   // Allocate memory
 
-  size_t const data_size =
-    m_max_fragment_size * m_bulk_size * m_credits * (m_endpoints.size() - 1);
+  size_t data_size = 0;
+  for (auto id : id_sequence) {
+    data_size += (id != m_id) ? memory_size(id) : 0;
+  }
   std::unique_ptr<unsigned char[]> const data_ptr(new unsigned char[data_size]);
   LOG(NOTICE) << "Builder Unit - Allocated " << data_size << " bytes of memory";
 
   // Connections
 
-  Acceptor<RecvSocket> acceptor(m_credits);
-/*
-  bool ep_created = false;
-  while (!ep_created) {
-    try {
-      acceptor.listen(m_endpoints[m_id].hostname(), m_endpoints[m_id].port());
-      ep_created = true;
-    } catch (std::exception& e) {
-      LOG(WARNING) << "Builder Unit - Error on listen ... Retrying!";
-      std::this_thread::sleep_for(std::chrono::seconds(1));
-    }
+  // Remote transports are accepted first, so that peers blocked while
+  // connecting to this node are never waiting for a local connection
+  std::vector<TransportType> transports = m_routing_table.transports();
+  std::stable_partition(
+    std::begin(transports),
+    std::end(transports),
+    [](TransportType type) {return type != TransportType::SHM;});
+
+  std::vector<std::unique_ptr<Acceptor> > acceptors;
+  for (auto type : transports) {
+    acceptors.push_back(make_acceptor(type, m_credits, m_tcp_options));
+    acceptors.back()->listen(
+      m_endpoints[m_id].hostname(),
+      m_endpoints[m_id].port());
   }
-*/
-
-  acceptor.listen(m_endpoints[m_id].hostname(), m_endpoints[m_id].port());
 
   LOG(NOTICE) << "Builder Unit - Waiting for connections...";
 
-  size_t const chunk_size = m_max_fragment_size * m_bulk_size;
+  unsigned char* base_data_ptr = data_ptr.get();
+  for (size_t t = 0; t < transports.size(); ++t) {
+    for (int n = 0; n < m_routing_table.count(transports[t]); ++n) {
 
-  for (int i = 0; i < m_endpoints.size() - 1; ++i) {
+      std::unique_ptr<RecvSocket> socket = acceptors[t]->accept();
+      int id = check_handshake(socket->peer_handshake(), transports[t]);
+      m_connection_ids[id] = std::move(socket);
+      auto& conn = *(m_connection_ids[id]);
 
-    // Create a temporary entry in the map with the local id
-    auto p = m_connection_ids.emplace(
-      std::make_pair(m_id, std::unique_ptr<RecvSocket>(acceptor.accept())));
-    int id = find_endpoint_id(m_endpoints, p.first->second->peer_hostname());
-    assert(id != -1 && "Address not found in endpoints list.");
-    // Insert the real id and delete the local one
-    m_connection_ids.emplace(std::make_pair(id, std::move(p.first->second)));
-    m_connection_ids.erase(p.first);
-    auto& conn = *(m_connection_ids.at(id));
+      conn.register_memory(base_data_ptr, memory_size(id));
 
-    unsigned char* base_data_ptr = data_ptr.get() + i * chunk_size * m_credits;
-    conn.register_memory(base_data_ptr, chunk_size * m_credits);
+      if (ring_mode(id)) {
+        conn.post_recv_ring(base_data_ptr, memory_size(id));
+      } else {
+        std::vector<iovec> iov_vect;
+        for (int j = 0; j < m_credits; ++j) {
+          iov_vect.push_back( { base_data_ptr + j * chunk_size(), chunk_size() });
+        }
+        conn.post_recv(iov_vect);
+        if (m_monitor.enabled()) {
+          m_monitor.posted(id, m_credits, CongestionMonitor::Clock::now());
+        }
+      }
+      base_data_ptr += memory_size(id);
 
-    std::vector<iovec> iov_vect;
-    for (int j = 0; j < m_credits; ++j) {
-      iov_vect.push_back( { base_data_ptr + j * chunk_size, chunk_size });
-    }
-    conn.post_recv(iov_vect);
+      // The connections that notify their completions are read only when
+      // ready, the other ones (and the local queue) at every iteration
+      if (!conn.notify_completions(m_ready_set, id)) {
+        m_polled_ids.push_back(id);
+      }
 
-    LOG(NOTICE)
-      << "Builder Unit - Connection established with ip "
-      << conn.peer_hostname();
+      LOG(NOTICE)
+        << "Builder Unit - Connection established with ip "
+        << conn.peer_hostname()
+        << " (ru "
+        << id
+        << ", "
+        << transport_to_string(transports[t])
+        << ")";
+    }
   }
   LOG(NOTICE) << "Builder Unit - All connections established";
 
+  // With an event manager, work is requested for all the free memory: a
+  // multievent from every source for each credit
+  if (m_control) {
+    m_control->send(
+      MessageType::WORK_REQUEST,
+      0,
+      { static_cast<uint64_t>(m_credits) });
+  }
+
   FrequencyMeter frequency(5.0);
   FrequencyMeter bandwith(5.0);  // this timeout is ignored (frequency is used)
 
@@ -191,21 +381,37 @@ void BuilderUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
   std::chrono::high_resolution_clock::time_point t_active;
   double active_time = 0;
 
+  std::vector<int> ready_ids;
+  // Whether the queues changed since the minimum was last computed
+  bool queues_changed = false;
+
   while (!(*stop)) {
 
     bool active_flag = false;
     t_active = std::chrono::high_resolution_clock::now();
 
     // Acquire
-    int min_wrs = m_credits;
-    for (auto id : id_sequence) {
+    ready_ids = m_polled_ids;
+    m_ready_set.take(ready_ids);
+    for (auto id : ready_ids) {
       int read_wrs = read_data(id);
       if (read_wrs) {
         LOG(DEBUG) << "Builder Unit - Read " << read_wrs << " wrs from conn " << id;
         active_flag = true;
       }
-      int const current_wrs = m_data_vect[id].size();
-      min_wrs = (min_wrs < current_wrs) ? min_wrs : current_wrs;
+    }
+
+    // The minimum is taken over all the sources, including those without new
+    // completions, whenever a read or a release changed any of the queues
+    queues_changed = queues_changed || active_flag;
+    int min_wrs = 0;
+    if (queues_changed) {
+      min_wrs = m_credits;
+      for (auto id : id_sequence) {
+        int const current_wrs = m_data_vect[id].size();
+        min_wrs = (min_wrs < current_wrs) ? min_wrs : current_wrs;
+      }
+      queues_changed = false;
     }
 
     if (min_wrs) {
@@ -213,6 +419,8 @@ void BuilderUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
         throw std::runtime_error("Error checking data");
       }
 
+      int const events = built_events(min_wrs);
+
       // Release
       for (auto id : id_sequence) {
         size_t const bytes = release_data(id, min_wrs);
@@ -221,7 +429,25 @@ void BuilderUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
         }
         LOG(DEBUG) << "Builder Unit - Released " << min_wrs << " wrs of conn " << id;
       }
-      frequency.add(min_wrs * m_bulk_size * m_endpoints.size());
+      queues_changed = true;
+      frequency.add(events * m_endpoints.size());
+      if (m_control) {
+        m_control->send(
+          MessageType::WORK_REQUEST,
+          0,
+          { static_cast<uint64_t>(min_wrs) });
+      }
+    }
+
+    // The queues left after building are the standing ones
+    if (m_monitor.enabled()) {
+      for (size_t i = 0; active_flag && i < id_sequence.size(); ++i) {
+        m_monitor.queued(id_sequence[i], m_data_vect[id_sequence[i]].size());
+      }
+      std::vector<uint64_t> values;
+      if (m_feedback && m_monitor.report(t_active, values)) {
+        m_feedback->send(MessageType::CONGESTION, 0, values);
+      }
     }
 
     if (active_flag) {
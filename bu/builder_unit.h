@@ -1,15 +1,23 @@
 #ifndef BU_BUILDER_UNIT_H
 #define BU_BUILDER_UNIT_H
 
-#include <map>
+#include <deque>
+#include <vector>
 #include <atomic>
 
 #include <sys/uio.h>
 
 #include <boost/lockfree/spsc_queue.hpp>
 
+#include "common/ready_set.h"
+
+#include "bu/congestion_monitor.h"
+
+#include "control/control_client.h"
+
 #include "transport/transport.h"
 #include "transport/endpoints.h"
+#include "transport/routing_table.h"
 
 namespace lseb {
 
@@ -17,25 +25,59 @@ class BuilderUnit {
   boost::lockfree::spsc_queue<iovec>& m_free_local_queue;
   boost::lockfree::spsc_queue<iovec>& m_ready_local_queue;
   std::vector<Endpoint> m_endpoints;
-  std::map<int, std::unique_ptr<RecvSocket> > m_connection_ids;
+  RoutingTable m_routing_table;
+  TcpOptions m_tcp_options;
+  std::vector<std::unique_ptr<RecvSocket> > m_connection_ids;
   std::vector<std::vector<iovec> > m_data_vect;
+  // Received transfers and number of their multievents not yet released
+  std::vector<std::deque<std::pair<iovec, int> > > m_transfers;
+  // With a byte budget, first piece of the multievent being received and
+  // the events received so far
+  std::vector<std::pair<iovec, int> > m_partial;
+  ReadySet m_ready_set;
+  std::vector<int> m_polled_ids;
   int m_bulk_size;
+  size_t m_bulked_bytes;
+  bool m_variable_bulk;
   int m_credits;
   int m_max_fragment_size;
+  size_t m_recv_ring_size;
+  int m_coalesce;
+  ControlClient* m_control;
+  CongestionMonitor m_monitor;
+  ControlClient* m_feedback;
   int m_id;
 
+  bool ring_mode(int id);
+  size_t chunk_size();
+  size_t memory_size(int id);
+  int split_transfer(
+    int id,
+    iovec const& transfer,
+    std::vector<iovec>& iov_vect);
   int read_data(int id);
+  int built_events(int n);
   bool check_data();
   size_t release_data(int id, int n);
+  int check_handshake(Handshake const& handshake, TransportType type);
 
  public:
   BuilderUnit(
     boost::lockfree::spsc_queue<iovec>& free_local_data,
     boost::lockfree::spsc_queue<iovec>& ready_local_data,
     std::vector<Endpoint> const& endpoints,
+    RoutingTable const& routing_table,
+    TcpOptions const& tcp_options,
     int bulk_size,
+    size_t bulked_bytes,
+    bool variable_bulk,
     int credits,
     int max_fragment_size,
+    size_t recv_ring_size,
+    int coalesce,
+    ControlClient* control,
+    CongestionMonitor const& monitor,
+    ControlClient* feedback,
     int id);
   void operator()(std::shared_ptr<std::atomic<bool> > stop);
 };
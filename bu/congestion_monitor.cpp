@@ -0,0 +1,74 @@
+#include "bu/congestion_monitor.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <cassert>
+
+namespace lseb {
+
+CongestionMonitor::CongestionMonitor(
+  int sources,
+  std::chrono::nanoseconds period,
+  int depth_threshold)
+    :
+      m_period(period),
+      m_depth_threshold(depth_threshold),
+      m_post_times(sources),
+      m_min_depth(sources, std::numeric_limits<int>::max()),
+      m_fill_time(sources, 0.),
+      m_fills(sources, 0),
+      m_last_report(Clock::now()) {
+  assert(m_depth_threshold > 0);
+}
+
+void CongestionMonitor::posted(
+  int source,
+  int buffers,
+  Clock::time_point now) {
+  auto& post_times = m_post_times[source];
+  post_times.insert(std::end(post_times), buffers, now);
+}
+
+// Receive buffers are filled in the order they were posted
+void CongestionMonitor::filled(
+  int source,
+  int buffers,
+  Clock::time_point now) {
+  auto& post_times = m_post_times[source];
+  assert(post_times.size() >= static_cast<size_t>(buffers));
+  for (int i = 0; i < buffers; ++i) {
+    m_fill_time[source] += std::chrono::duration<double, std::nano>(
+      now - post_times.front()).count();
+    post_times.pop_front();
+  }
+  m_fills[source] += buffers;
+}
+
+void CongestionMonitor::queued(int source, int depth) {
+  m_min_depth[source] = std::min(m_min_depth[source], depth);
+}
+
+bool CongestionMonitor::report(
+  Clock::time_point now,
+  std::vector<uint64_t>& values) {
+  if (!enabled() || now - m_last_report < m_period) {
+    return false;
+  }
+  m_last_report = now;
+  values.clear();
+  for (size_t i = 0; i < m_min_depth.size(); ++i) {
+    // Sources without samples in the period have no queue
+    int const depth =
+      (m_min_depth[i] == std::numeric_limits<int>::max()) ? 0 : m_min_depth[i];
+    values.push_back(depth >= m_depth_threshold);
+    values.push_back(depth);
+    values.push_back(m_fills[i] ? m_fill_time[i] / m_fills[i] : 0);
+    m_min_depth[i] = std::numeric_limits<int>::max();
+    m_fill_time[i] = 0.;
+    m_fills[i] = 0;
+  }
+  return true;
+}
+
+}
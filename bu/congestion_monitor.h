@@ -0,0 +1,54 @@
+#ifndef BU_CONGESTION_MONITOR_H
+#define BU_CONGESTION_MONITOR_H
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include <cstdint>
+
+namespace lseb {
+
+// Congestion signals measured by the BU for each source: the depth of its
+// receive queue (multievents received but not built yet) and the time between
+// posting a receive buffer and having it filled. The BU builds at the pace of
+// the slowest source, so a source whose queue never drains below the threshold
+// during a period (a standing queue, as in CoDel) is sending ahead of the
+// others and its traffic only loads the network: it is marked, as ECN would,
+// and its RU slows down (see CongestionPacer).
+// The values of a CONGESTION message are (marked, minimum depth, mean fill
+// time in ns) triplets, one per source.
+class CongestionMonitor {
+ public:
+  using Clock = std::chrono::high_resolution_clock;
+
+ private:
+  std::chrono::nanoseconds m_period;
+  int m_depth_threshold;
+  std::vector<std::deque<Clock::time_point> > m_post_times;
+  std::vector<int> m_min_depth;
+  std::vector<double> m_fill_time;
+  std::vector<int> m_fills;
+  Clock::time_point m_last_report;
+
+ public:
+  // A null period disables the monitor
+  CongestionMonitor(
+    int sources,
+    std::chrono::nanoseconds period,
+    int depth_threshold);
+  bool enabled() const {
+    return m_period.count() != 0;
+  }
+  // Receive buffers posted to (or filled by) the source
+  void posted(int source, int buffers, Clock::time_point now);
+  void filled(int source, int buffers, Clock::time_point now);
+  // Current depth of the receive queue of the source
+  void queued(int source, int depth);
+  // Once per period, the values of the report of the elapsed period
+  bool report(Clock::time_point now, std::vector<uint64_t>& values);
+};
+
+}
+
+#endif
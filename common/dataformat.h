@@ -5,6 +5,7 @@
 
 #include "common/utility.h"
 #include "common/range.h"
+#include "common/ring.h"
 
 namespace lseb {
 
@@ -32,12 +33,19 @@ struct EventHeader {
   }
 };
 
+// Flag of the events rejected by the trigger of the RU, whose header is sent
+// without the payload
+static uint64_t const rejected_event_flag = uint64_t(1) << 63;
+
 using MetaDataRange = Range<EventMetaData>;
 using DataRange = Range<unsigned char>;
 
 using MetaDataBuffer = Buffer<EventMetaData>;
 using DataBuffer = Buffer<unsigned char>;
 
+using MetaDataRing = RingBuffer<EventMetaData>;
+using DataRing = RingBuffer<unsigned char>;
+
 using MultiEvent = std::pair<MetaDataRange, DataRange>;
 
 }
@@ -0,0 +1,110 @@
+#ifndef COMMON_MIRROR_RING_H
+#define COMMON_MIRROR_RING_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace lseb {
+
+// A buffer mapped twice back to back in virtual memory: the byte at begin() +
+// size() + i is the one at begin() + i. Any span of up to size() bytes that
+// starts in the buffer is then contiguous, even if it wraps around its end.
+// The size is a multiple of the page size.
+class MirrorRing {
+  unsigned char* m_begin;
+  size_t m_size;
+
+ public:
+  static size_t page_size() {
+    return sysconf(_SC_PAGESIZE);
+  }
+
+  // Smallest size of a ring holding size bytes
+  static size_t round_size(size_t size) {
+    size_t const page = page_size();
+    return std::max(page, (size + page - 1) / page * page);
+  }
+
+  explicit MirrorRing(size_t size)
+      :
+        m_begin(nullptr),
+        m_size(size) {
+    if (!m_size || m_size % page_size()) {
+      throw std::runtime_error(
+        "Wrong size of mirror ring: " + std::to_string(m_size));
+    }
+
+    int const fd = memfd_create("lseb_ring", 0);
+    if (fd == -1) {
+      throw std::runtime_error(
+        "Error on memfd_create: " + std::string(strerror(errno)));
+    }
+    if (ftruncate(fd, m_size) == -1) {
+      int const error = errno;
+      close(fd);
+      throw std::runtime_error(
+        "Error on ftruncate: " + std::string(strerror(error)));
+    }
+
+    // Reserve both halves, then map the same pages over each of them
+    void* const range = mmap(
+      NULL,
+      2 * m_size,
+      PROT_NONE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+    if (range == MAP_FAILED) {
+      int const error = errno;
+      close(fd);
+      throw std::runtime_error("Error on mmap: " + std::string(strerror(error)));
+    }
+    unsigned char* const begin = static_cast<unsigned char*>(range);
+    for (int half = 0; half < 2; ++half) {
+      if (mmap(
+        begin + half * m_size,
+        m_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_FIXED,
+        fd,
+        0) == MAP_FAILED) {
+        int const error = errno;
+        munmap(range, 2 * m_size);
+        close(fd);
+        throw std::runtime_error(
+          "Error on mmap: " + std::string(strerror(error)));
+      }
+    }
+    // The mappings keep the memory alive
+    close(fd);
+    m_begin = begin;
+  }
+
+  ~MirrorRing() {
+    munmap(m_begin, 2 * m_size);
+  }
+
+  MirrorRing(MirrorRing const&) = delete;
+  MirrorRing& operator=(MirrorRing const&) = delete;
+
+  unsigned char* begin() const {
+    return m_begin;
+  }
+  unsigned char* end() const {
+    return m_begin + m_size;
+  }
+  size_t size() const {
+    return m_size;
+  }
+};
+
+}
+
+#endif
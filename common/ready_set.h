@@ -0,0 +1,58 @@
+#ifndef COMMON_READY_SET_H
+#define COMMON_READY_SET_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <cassert>
+#include <cstdint>
+
+namespace lseb {
+
+// Set of connection ids with new completions, filled by the completion
+// handlers and drained by the polling loop. It is a bitmap of atomic words,
+// so that notifying is wait-free and draining costs a word per 64 ids.
+class ReadySet {
+  int m_size;
+  std::unique_ptr<std::atomic<uint64_t>[]> m_words;
+
+  int words() const {
+    return (m_size + 63) / 64;
+  }
+
+ public:
+  explicit ReadySet(int size)
+      :
+        m_size(size),
+        m_words(new std::atomic<uint64_t>[(size + 63) / 64]) {
+    for (int i = 0; i < words(); ++i) {
+      m_words[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void notify(int id) {
+    assert(id >= 0 && id < m_size);
+    m_words[id / 64].fetch_or(
+      uint64_t(1) << (id % 64),
+      std::memory_order_release);
+  }
+
+  // Appends to ids the notified ids (in increasing order) and clears them
+  void take(std::vector<int>& ids) {
+    for (int i = 0; i < words(); ++i) {
+      if (!m_words[i].load(std::memory_order_relaxed)) {
+        continue;
+      }
+      uint64_t word = m_words[i].exchange(0, std::memory_order_acquire);
+      while (word) {
+        ids.push_back(i * 64 + __builtin_ctzll(word));
+        word &= word - 1;
+      }
+    }
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef COMMON_RING_H
+#define COMMON_RING_H
+
+#include <cassert>
+#include <cstdint>
+
+namespace lseb {
+
+inline bool is_power_of_two(uint64_t n) {
+  return n && !(n & (n - 1));
+}
+
+// Smallest power of two not less than n
+inline uint64_t next_power_of_two(uint64_t n) {
+  uint64_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+// A power-of-two number of elements addressed by 64-bit indices that only
+// increase: the element of an index is found with a mask, and the distance
+// between two indices is a plain subtraction.
+template<typename T>
+class Ring {
+  T* m_begin;
+  uint64_t m_mask;
+
+ public:
+  Ring(T* begin, T* end)
+      :
+        m_begin(begin),
+        m_mask(end - begin - 1) {
+    assert(is_power_of_two(end - begin) && "Size not a power of two");
+  }
+  T* begin() const {
+    return m_begin;
+  }
+  T* end() const {
+    return m_begin + size();
+  }
+  uint64_t size() const {
+    return m_mask + 1;
+  }
+  // Position in the ring of an index, or of a difference of indices
+  uint64_t offset(uint64_t index) const {
+    return index & m_mask;
+  }
+  T& operator[](uint64_t index) const {
+    return m_begin[offset(index)];
+  }
+};
+
+// Elements written and read in order: the elements between the read and the
+// write index are ready. Unlike Buffer, the ring can be completely filled.
+template<typename T>
+class RingBuffer {
+  Ring<T> m_ring;
+  uint64_t m_read;
+  uint64_t m_write;
+
+ public:
+  RingBuffer(T* begin, T* end)
+      :
+        m_ring(begin, end),
+        m_read(0),
+        m_write(0) {
+  }
+  Ring<T> const& ring() const {
+    return m_ring;
+  }
+  uint64_t size() const {
+    return m_ring.size();
+  }
+  uint64_t read_index() const {
+    return m_read;
+  }
+  uint64_t write_index() const {
+    return m_write;
+  }
+  T& next_read() const {
+    return m_ring[m_read];
+  }
+  T& next_write() const {
+    return m_ring[m_write];
+  }
+  uint64_t ready() const {
+    return m_write - m_read;
+  }
+  uint64_t available() const {
+    return size() - ready();
+  }
+  void release(uint64_t n) {
+    assert(ready() >= n);
+    m_read += n;
+  }
+  void reserve(uint64_t n) {
+    assert(available() >= n);
+    m_write += n;
+  }
+};
+
+}
+
+#endif
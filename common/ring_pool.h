@@ -0,0 +1,75 @@
+#ifndef COMMON_RING_POOL_H
+#define COMMON_RING_POOL_H
+
+#include <deque>
+
+#include <cassert>
+#include <cstdint>
+#include <sys/uio.h>
+
+namespace lseb {
+
+// Variable-size allocations placed back to back in a buffer and released in
+// the same order. An allocation never wraps: the tail of the buffer is skipped
+// when it is too short.
+class RingPool {
+  unsigned char* m_buffer;
+  size_t m_buffer_len;
+  uint64_t m_alloc;
+  uint64_t m_free;
+  std::deque<std::pair<void*, size_t> > m_allocated;
+
+ public:
+  RingPool()
+      :
+        m_buffer(nullptr),
+        m_buffer_len(0),
+        m_alloc(0),
+        m_free(0) {
+  }
+
+  RingPool(unsigned char* buffer, size_t buffer_len)
+      :
+        m_buffer(buffer),
+        m_buffer_len(buffer_len),
+        m_alloc(0),
+        m_free(0) {
+  }
+
+  // Returns an empty iovec if there is not enough contiguous space
+  iovec alloc(size_t len) {
+    assert(len && len <= m_buffer_len && "Wrong size");
+    if (m_allocated.empty()) {
+      // Restart from the beginning of the buffer
+      m_alloc = m_free = 0;
+    }
+    size_t const offset = m_alloc % m_buffer_len;
+    size_t const skip = (offset + len > m_buffer_len) ? m_buffer_len - offset : 0;
+    if (m_buffer_len - (m_alloc - m_free) < skip + len) {
+      return {nullptr, 0};
+    }
+    iovec iov = { m_buffer + (offset + skip) % m_buffer_len, len };
+    m_alloc += skip + len;
+    m_allocated.emplace_back(iov.iov_base, skip + len);
+    return iov;
+  }
+
+  void free(iovec iov) {
+    assert(!m_allocated.empty());
+    assert(m_allocated.front().first == iov.iov_base && "Out of order release");
+    m_free += m_allocated.front().second;
+    m_allocated.pop_front();
+  }
+
+  size_t available() {
+    return m_buffer_len - (m_alloc - m_free);
+  }
+
+  bool empty() {
+    return m_allocated.empty();
+  }
+};
+
+}
+
+#endif
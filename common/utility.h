@@ -8,9 +8,12 @@
 #include <numeric>
 #include <random>
 #include <algorithm>
+#include <thread>
 
 #include <cassert>
 
+#include <pthread.h>
+#include <sched.h>
 #include <sys/uio.h>
 
 #include "common/pointer_cast.h"
@@ -116,6 +119,14 @@ inline std::vector<int> create_sequence(int id, int total) {
   return sequence;
 }
 
+// Returns false if the thread can not run on that cpu
+inline bool pin_thread(std::thread& thread, int cpu) {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  return !pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+}
+
 }
 
 #endif
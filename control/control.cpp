@@ -0,0 +1,106 @@
+#include "control/control.h"
+
+#include <cstring>
+
+#include "common/log.hpp"
+
+namespace lseb {
+
+ControlConnection::ControlConnection(
+  boost::asio::io_service& io_service,
+  boost::asio::ip::tcp::socket socket,
+  Handler handler)
+    :
+      m_io_service(io_service),
+      m_socket(std::move(socket)),
+      m_handler(handler) {
+  m_socket.set_option(boost::asio::ip::tcp::no_delay(true));
+}
+
+void ControlConnection::start() {
+  read_header();
+}
+
+void ControlConnection::read_header() {
+  auto self = shared_from_this();
+  boost::asio::async_read(
+    m_socket,
+    boost::asio::buffer(&m_header, sizeof(m_header)),
+    [this, self](boost::system::error_code const& error, size_t) {
+      if (error) {
+        if (error != boost::asio::error::eof
+          && error != boost::asio::error::operation_aborted) {
+          LOG(WARNING)
+            << "Control connection - Error on read: "
+            << error.message();
+        }
+        return;
+      }
+      m_values.resize(m_header.count);
+      read_values();
+    });
+}
+
+void ControlConnection::read_values() {
+  auto self = shared_from_this();
+  boost::asio::async_read(
+    m_socket,
+    boost::asio::buffer(m_values),
+    [this, self](boost::system::error_code const& error, size_t) {
+      if (error) {
+        LOG(WARNING)
+          << "Control connection - Error on read: "
+          << error.message();
+        return;
+      }
+      ControlMessage const message = { static_cast<MessageType>(m_header.type),
+        m_header.source, m_header.epoch, m_values };
+      m_handler(message);
+      read_header();
+    });
+}
+
+void ControlConnection::send(ControlMessage const& message) {
+  ControlHeader const header = { static_cast<uint32_t>(message.type),
+    message.source, message.epoch, message.values.size() };
+  std::vector<unsigned char> buffer(
+    sizeof(header) + message.values.size() * sizeof(uint64_t));
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  if (!message.values.empty()) {
+    std::memcpy(
+      buffer.data() + sizeof(header),
+      message.values.data(),
+      message.values.size() * sizeof(uint64_t));
+  }
+
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_write_queue.push_back(std::move(buffer));
+  if (m_write_queue.size() == 1) {
+    auto self = shared_from_this();
+    m_io_service.post([this, self]() {write();});
+  }
+}
+
+void ControlConnection::write() {
+  auto self = shared_from_this();
+  boost::mutex::scoped_lock lock(m_mutex);
+  boost::asio::async_write(
+    m_socket,
+    boost::asio::buffer(m_write_queue.front()),
+    [this, self](boost::system::error_code const& error, size_t) {
+      if (error) {
+        LOG(WARNING)
+          << "Control connection - Error on write: "
+          << error.message();
+        return;
+      }
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_write_queue.pop_front();
+      if (!m_write_queue.empty()) {
+        lock.unlock();
+        write();
+      }
+    });
+}
+
+}
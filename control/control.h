@@ -0,0 +1,75 @@
+#ifndef CONTROL_CONTROL_H
+#define CONTROL_CONTROL_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <cstdint>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+namespace lseb {
+
+// Messages exchanged with the manager rank. They are small and rare compared
+// to the data messages, so they always travel on a TCP connection.
+enum class MessageType : uint32_t {
+  LOAD_REPORT,  // rank -> manager: load of each destination seen by the RU
+  ASSIGNMENT,  // manager -> ranks: destinations of the multievents of an epoch
+  WORK_REQUEST,  // BU -> manager: number of multievents it can accept
+  EVENT_RANGES,  // manager -> ranks: ranges of multievents of a cycle per BU
+  CONGESTION,  // BU -> ranks, relayed by the manager: state of each source
+  BULK_REPORT,  // rank -> manager: completion latency seen by the RU
+  BULK_SIZE,  // manager -> ranks: events in the multievents of an epoch
+  HELLO  // rank -> manager: first message on a control connection
+};
+
+struct ControlMessage {
+  MessageType type;
+  uint32_t source;
+  uint64_t epoch;
+  std::vector<uint64_t> values;
+};
+
+// Header preceding the values on the wire
+struct ControlHeader {
+  uint32_t type;
+  uint32_t source;
+  uint64_t epoch;
+  uint64_t count;
+};
+
+// One end of a control connection. Messages are read and written
+// asynchronously; the handler is called by the thread running the io_service.
+class ControlConnection : public std::enable_shared_from_this<
+  ControlConnection> {
+ public:
+  using Handler = std::function<void(ControlMessage const&)>;
+
+ private:
+  boost::asio::io_service& m_io_service;
+  boost::asio::ip::tcp::socket m_socket;
+  Handler m_handler;
+  ControlHeader m_header;
+  std::vector<uint64_t> m_values;
+  boost::mutex m_mutex;
+  std::deque<std::vector<unsigned char> > m_write_queue;
+  void read_header();
+  void read_values();
+  void write();
+
+ public:
+  ControlConnection(
+    boost::asio::io_service& io_service,
+    boost::asio::ip::tcp::socket socket,
+    Handler handler);
+  void start();
+  // Can be called by any thread
+  void send(ControlMessage const& message);
+};
+
+}
+
+#endif
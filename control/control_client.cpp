@@ -0,0 +1,72 @@
+#include "control/control_client.h"
+
+#include <chrono>
+
+#include "common/log.hpp"
+
+namespace lseb {
+
+ControlClient::ControlClient(
+  std::string const& hostname,
+  std::string const& port,
+  int rank)
+    :
+      m_io_service(),
+      m_work(m_io_service),
+      m_rank(rank),
+      m_available(0) {
+  boost::asio::ip::tcp::resolver resolver(m_io_service);
+  boost::asio::ip::tcp::resolver::query query(hostname, port);
+  boost::asio::ip::tcp::socket socket(m_io_service);
+  bool connected = false;
+  while (!connected) {
+    boost::system::error_code error;
+    boost::asio::connect(socket, resolver.resolve(query), error);
+    if (error) {
+      socket.close();
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    } else {
+      connected = true;
+    }
+  }
+  LOG(INFO) << "Control client - Connected to " << hostname << ":" << port;
+  m_connection = std::make_shared<ControlConnection>(
+    m_io_service,
+    std::move(socket),
+    [this](ControlMessage const& message) {push(message);});
+  m_connection->start();
+  m_thread = std::thread([this]() {m_io_service.run();});
+  send(MessageType::HELLO, 0, { });
+}
+
+ControlClient::~ControlClient() {
+  m_io_service.stop();
+  m_thread.join();
+}
+
+void ControlClient::push(ControlMessage const& message) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_received[message.type].push_back(message);
+  ++m_available;
+}
+
+void ControlClient::send(
+  MessageType type,
+  uint64_t epoch,
+  std::vector<uint64_t> const& values) {
+  m_connection->send( { type, m_rank, epoch, values });
+}
+
+std::vector<ControlMessage> ControlClient::poll(MessageType type) {
+  std::vector<ControlMessage> messages;
+  if (m_available) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    auto& queue = m_received[type];
+    messages.assign(std::begin(queue), std::end(queue));
+    m_available -= queue.size();
+    queue.clear();
+  }
+  return messages;
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef CONTROL_CONTROL_CLIENT_H
+#define CONTROL_CONTROL_CLIENT_H
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include "control/control.h"
+
+namespace lseb {
+
+// Control connection of a rank towards the manager. Received messages are
+// queued by type and retrieved without blocking by the polling loops.
+class ControlClient {
+  boost::asio::io_service m_io_service;
+  boost::asio::io_service::work m_work;
+  std::shared_ptr<ControlConnection> m_connection;
+  uint32_t m_rank;
+  boost::mutex m_mutex;
+  std::map<MessageType, std::deque<ControlMessage> > m_received;
+  std::atomic<int> m_available;
+  std::thread m_thread;
+  void push(ControlMessage const& message);
+
+ public:
+  // Retries until the manager accepts the connection
+  ControlClient(std::string const& hostname, std::string const& port, int rank);
+  ~ControlClient();
+  int rank() const {
+    return m_rank;
+  }
+  void send(
+    MessageType type,
+    uint64_t epoch,
+    std::vector<uint64_t> const& values);
+  std::vector<ControlMessage> poll(MessageType type);
+
+  ControlClient(const ControlClient&) = delete;            // disable copying
+  ControlClient& operator=(const ControlClient&) = delete;  // disable assignment
+};
+
+}
+
+#endif
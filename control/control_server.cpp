@@ -0,0 +1,85 @@
+#include "control/control_server.h"
+
+#include "common/log.hpp"
+
+namespace lseb {
+
+ControlServer::ControlServer(
+  std::string const& hostname,
+  std::string const& port,
+  int nodes,
+  Handler handler)
+    :
+      m_io_service(),
+      m_work(m_io_service),
+      m_acceptor(m_io_service),
+      m_socket(m_io_service),
+      m_handler(handler),
+      m_nodes(nodes) {
+  boost::asio::ip::tcp::endpoint endpoint(
+    boost::asio::ip::address::from_string(hostname),
+    std::stol(port));
+  m_acceptor.open(endpoint.protocol());
+  m_acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+  m_acceptor.bind(endpoint);
+  m_acceptor.listen();
+  accept();
+  m_thread = std::thread([this]() {m_io_service.run();});
+}
+
+ControlServer::~ControlServer() {
+  m_io_service.stop();
+  m_thread.join();
+}
+
+void ControlServer::accept() {
+  m_acceptor.async_accept(
+    m_socket,
+    [this](boost::system::error_code const& error) {
+      if (error) {
+        LOG(WARNING) << "Control server - Error on accept: " << error.message();
+        return;
+      }
+      auto connection = std::make_shared<ControlConnection>(
+        m_io_service,
+        std::move(m_socket),
+        [this](ControlMessage const& message) {receive(message);});
+      connection->start();
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_connections.push_back(connection);
+      lock.unlock();
+      m_socket = boost::asio::ip::tcp::socket(m_io_service);
+      accept();
+    });
+}
+
+void ControlServer::receive(ControlMessage const& message) {
+  if (message.type != MessageType::HELLO) {
+    m_handler(message);
+    return;
+  }
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_ranks.insert(message.source);
+  if (static_cast<int>(m_ranks.size()) == m_nodes) {
+    LOG(INFO) << "Control server - All the " << m_nodes << " ranks connected";
+    for (auto const& held : m_held) {
+      for (auto& connection : m_connections) {
+        connection->send(held);
+      }
+    }
+    m_held.clear();
+  }
+}
+
+void ControlServer::broadcast(ControlMessage const& message) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (static_cast<int>(m_ranks.size()) < m_nodes) {
+    m_held.push_back(message);
+    return;
+  }
+  for (auto& connection : m_connections) {
+    connection->send(message);
+  }
+}
+
+}
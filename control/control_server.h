@@ -0,0 +1,56 @@
+#ifndef CONTROL_CONTROL_SERVER_H
+#define CONTROL_CONTROL_SERVER_H
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include "control/control.h"
+
+namespace lseb {
+
+// Runs on the manager rank and accepts a control connection from every rank.
+// The handler is called by the internal thread for each received message.
+// Broadcasts are held until all the ranks have connected and said hello, so
+// that a rank connecting late does not miss the first assignments.
+class ControlServer {
+ public:
+  using Handler = std::function<void(ControlMessage const&)>;
+
+ private:
+  boost::asio::io_service m_io_service;
+  boost::asio::io_service::work m_work;
+  boost::asio::ip::tcp::acceptor m_acceptor;
+  boost::asio::ip::tcp::socket m_socket;
+  Handler m_handler;
+  int m_nodes;
+  boost::mutex m_mutex;
+  std::vector<std::shared_ptr<ControlConnection> > m_connections;
+  std::set<uint32_t> m_ranks;
+  std::vector<ControlMessage> m_held;
+  std::thread m_thread;
+  void accept();
+  void receive(ControlMessage const& message);
+
+ public:
+  ControlServer(
+    std::string const& hostname,
+    std::string const& port,
+    int nodes,
+    Handler handler);
+  ~ControlServer();
+  void broadcast(ControlMessage const& message);
+
+  ControlServer(const ControlServer&) = delete;            // disable copying
+  ControlServer& operator=(const ControlServer&) = delete;  // disable assignment
+};
+
+}
+
+#endif
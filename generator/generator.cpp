@@ -1,5 +1,7 @@
 #include "generator/generator.h"
 
+#include <algorithm>
+
 #include <cmath>
 #include <cassert>
 
@@ -17,97 +19,65 @@ Generator::Generator(
   size_t id)
     :
       m_length_generator(length_generator),
-      m_metadata_buffer(std::begin(metadata_range), std::end(metadata_range)),
+      m_metadata(
+        const_cast<EventMetaData*>(std::begin(metadata_range)),
+        const_cast<EventMetaData*>(std::end(metadata_range))),
+      m_data(
+        const_cast<unsigned char*>(std::begin(data_range)),
+        const_cast<unsigned char*>(std::end(data_range))),
       m_id(id) {
 
-  DataBuffer data_buffer(std::begin(data_range), std::end(data_range));
-
   assert(data_padding >= sizeof(EventHeader));
-  assert(data_buffer.size() % data_padding == 0);
-
-  uint64_t events_counter = 0;
-  uint64_t offset = 0;
-
-  bool metadata_avail = true;
-  while (metadata_avail) {
+  assert(m_data.size() % data_padding == 0);
 
+  for (uint64_t i = 0; i < m_metadata.size(); ++i) {
     size_t event_size = sizeof(EventHeader) + m_length_generator.generate();
     // round down
     event_size -= (event_size % data_padding);
-
-    if (data_buffer.available() < event_size + (m_metadata_buffer.available() - 1) * sizeof(EventHeader)) {
-      event_size = sizeof(EventHeader);
-    }
-
-    if (m_metadata_buffer.available() == 1) {
-      metadata_avail = false;
-    }
-
-    // Set EventMetaData
-    EventMetaData& metadata =
-      *(new (m_metadata_buffer.next_write()) EventMetaData(
-        events_counter,
-        event_size,
-        offset));
-
-    // Set EventHeader
-    EventHeader& header = *(new (
-      pointer_cast<EventHeader>(data_buffer.next_write())) EventHeader(
-      events_counter,
-      metadata.length,
-      m_id));
-
-    // The buffer can not be completely filled
-    if (m_metadata_buffer.available() != 1) {
-      m_metadata_buffer.reserve(1);
-      data_buffer.reserve(event_size);
-    }
-
-    offset = (offset + event_size) % data_buffer.size();
-    ++events_counter;
+    event_size = std::min<size_t>(
+      std::max(event_size, data_padding),
+      m_data.size());
+    // The offset is set when the event is generated
+    new (&m_metadata.ring()[i]) EventMetaData(i, event_size, 0);
   }
 
-  m_metadata_buffer.release(m_metadata_buffer.ready());
-  data_buffer.release(data_buffer.ready());
-
-  LOG(NOTICE) << "Generator - Capacity of " << events_counter << " events";
-
-// Check that all memory is free
-  assert(!m_metadata_buffer.ready() && !data_buffer.ready());
+  LOG(NOTICE)
+    << "Generator - Capacity of "
+    << m_metadata.size()
+    << " events and "
+    << m_data.size()
+    << " bytes";
 }
 
 void Generator::releaseEvents(size_t n_events) {
-
-  assert(m_metadata_buffer.ready() >= n_events);
-
-  if (n_events) {
-    // Release metadata
-    m_metadata_buffer.release(n_events - 1);
-    EventMetaData const& metadata = *(pointer_cast<EventMetaData>(
-      m_metadata_buffer.next_read()));
-    m_metadata_buffer.release(1);
+  assert(m_metadata.ready() >= n_events);
+  for (size_t i = 0; i < n_events; ++i) {
+    m_data.release(m_metadata.next_read().length);
+    m_metadata.release(1);
   }
 }
 
 size_t Generator::generateEvents(size_t n_events) {
 
-  // The buffer can not be completely filled
-  size_t avail_events =
-      (n_events <= m_metadata_buffer.available() - 1) ?
-        n_events :
-        m_metadata_buffer.available() - 1;
-
-  if (avail_events) {
-    // Release metadata
-    m_metadata_buffer.reserve(avail_events - 1);
-    EventMetaData const& metadata = *(pointer_cast<EventMetaData>(
-      m_metadata_buffer.next_write()));
-    m_metadata_buffer.reserve(1);
-  }/* else if (n_events) {
-    LOG(WARNING) << "Generator - Not enough space for events generation!";
-  }*/
+  // The header of each event is written, as a front-end would do. Events are
+  // numbered in the order they are generated, the same in all the RUs.
+  size_t events = 0;
+  while (events < n_events && m_metadata.available()) {
+    EventMetaData& metadata = m_metadata.next_write();
+    if (m_data.available() < metadata.length) {
+      break;
+    }
+    metadata.offset = m_data.ring().offset(m_data.write_index());
+    new (pointer_cast<EventHeader>(&m_data.next_write())) EventHeader(
+      m_metadata.write_index(),
+      metadata.length,
+      m_id);
+    m_data.reserve(metadata.length);
+    m_metadata.reserve(1);
+    ++events;
+  }
 
-  return avail_events;
+  return events;
 }
 
 }
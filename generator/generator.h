@@ -8,9 +8,16 @@
 
 namespace lseb {
 
+// The lengths of the events are drawn once, one for each metadata slot, and
+// the events are written back to back in the data ring, as a readout board
+// would do: an event may cross the end of the data buffer, which must then be
+// mapped twice (see MirrorRing). An event is generated when both its metadata
+// slot and its data are free. The metadata and the data rings have a
+// power-of-two size.
 class Generator {
   LengthGenerator m_length_generator;
-  MetaDataBuffer m_metadata_buffer;
+  MetaDataRing m_metadata;
+  DataRing m_data;
   size_t m_id;
 
  public:
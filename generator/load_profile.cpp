@@ -0,0 +1,116 @@
+#include "generator/load_profile.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#include <cassert>
+#include <cctype>
+#include <cmath>
+
+namespace lseb {
+
+LoadProfile::LoadProfile(std::vector<RateSegment> const& segments)
+    :
+      m_period(0.),
+      m_period_events(0.) {
+  for (auto const& segment : segments) {
+    if (segment.duration <= 0. || segment.rate < 0.) {
+      throw std::runtime_error("Wrong segment of load profile");
+    }
+    m_start_times.push_back(m_period);
+    m_start_events.push_back(m_period_events);
+    m_rates.push_back(segment.rate);
+    m_period += segment.duration;
+    m_period_events += segment.duration * segment.rate;
+  }
+  if (!m_period_events) {
+    throw std::runtime_error("Load profile without events");
+  }
+}
+
+double LoadProfile::trigger_time(uint64_t event) const {
+  double periods = std::floor(event / m_period_events);
+  double events = event - periods * m_period_events;
+  // With rounding the first event of a period can fall at the end of the
+  // previous one, past the trailing gaps
+  if (events >= m_period_events) {
+    periods += 1.;
+    events = std::max(0., events - m_period_events);
+  }
+  // The last segment starting at or before the event has a rate: the gaps
+  // before it start with the same number of events
+  auto const it = std::upper_bound(
+    std::begin(m_start_events),
+    std::end(m_start_events),
+    events) - 1;
+  auto const i = std::distance(std::begin(m_start_events), it);
+  assert(m_rates[i] > 0.);
+  return periods * m_period + m_start_times[i]
+    + (events - m_start_events[i]) / m_rates[i];
+}
+
+uint64_t LoadProfile::events_before(double time) const {
+  double const periods = std::floor(time / m_period);
+  double const offset = time - periods * m_period;
+  auto const it = std::upper_bound(
+    std::begin(m_start_times),
+    std::end(m_start_times),
+    offset) - 1;
+  auto const i = std::distance(std::begin(m_start_times), it);
+  return std::ceil(
+    periods * m_period_events + m_start_events[i]
+      + (offset - m_start_times[i]) * m_rates[i]);
+}
+
+LoadProfile uniform_profile(double frequency) {
+  // A period of one second keeps the events of a period integer
+  return LoadProfile( { { 1., frequency } });
+}
+
+LoadProfile filling_scheme_profile(
+  std::string const& bunches,
+  double crossing_frequency) {
+  // Runs of filled and empty crossings
+  std::vector<RateSegment> segments;
+  double const crossing = 1. / crossing_frequency;
+  for (char c : bunches) {
+    if (std::isspace(c)) {
+      continue;
+    }
+    if (c != '0' && c != '1') {
+      throw std::runtime_error(
+        std::string("Wrong bunch crossing in filling scheme: ") + c);
+    }
+    double const rate = (c == '1') ? crossing_frequency : 0.;
+    if (!segments.empty() && segments.back().rate == rate) {
+      segments.back().duration += crossing;
+    } else {
+      segments.push_back( { crossing, rate });
+    }
+  }
+  return LoadProfile(segments);
+}
+
+LoadProfile burst_profile(
+  double frequency,
+  double burst_frequency,
+  double burst_rate,
+  double burst_length,
+  unsigned int seed,
+  int bursts) {
+  assert(burst_rate > 0. && burst_length > 0. && bursts > 0);
+  std::mt19937 generator(seed);
+  std::exponential_distribution<> gap(burst_rate);
+  std::vector<RateSegment> segments;
+  for (int b = 0; b < bursts; ++b) {
+    double const duration = gap(generator);
+    if (duration > 0.) {
+      segments.push_back( { duration, frequency });
+    }
+    segments.push_back( { burst_length, burst_frequency });
+  }
+  return LoadProfile(segments);
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef GENERATOR_LOAD_PROFILE_H
+#define GENERATOR_LOAD_PROFILE_H
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+namespace lseb {
+
+// Piece of a load profile: rate (Hz) of the events for a duration (seconds)
+struct RateSegment {
+  double duration;
+  double rate;
+};
+
+// Trigger schedule of the events: a timeline of rates repeated from the start
+// of the run. The n-th event is triggered when n events are due according to
+// the rates, so the schedule is a function of the profile only and is the
+// same in all the RUs. Segments with a null rate are gaps without events.
+class LoadProfile {
+  std::vector<double> m_start_times;
+  std::vector<double> m_start_events;
+  std::vector<double> m_rates;
+  double m_period;
+  double m_period_events;
+
+ public:
+  explicit LoadProfile(std::vector<RateSegment> const& segments);
+  // Time (seconds from the start) at which the n-th event is triggered
+  double trigger_time(uint64_t event) const;
+  // Number of events triggered before a time
+  uint64_t events_before(double time) const;
+  double mean_rate() const {
+    return m_period_events / m_period;
+  }
+};
+
+// Events at a fixed frequency
+LoadProfile uniform_profile(double frequency);
+
+// One event for each filled bunch crossing of an orbit, given as a string of
+// '1' (filled) and '0' (empty) crossings at the crossing frequency. White
+// space in the string is ignored.
+LoadProfile filling_scheme_profile(
+  std::string const& bunches,
+  double crossing_frequency);
+
+// Events at frequency, interrupted by bursts lasting burst_length seconds
+// during which the rate is burst_frequency instead. The bursts start as a
+// Poisson process of burst_rate bursts per second. The timeline holds the
+// given number of bursts, drawn from seed, and then repeats.
+LoadProfile burst_profile(
+  double frequency,
+  double burst_frequency,
+  double burst_rate,
+  double burst_length,
+  unsigned int seed,
+  int bursts = 1024);
+
+}
+
+#endif
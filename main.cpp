@@ -1,6 +1,7 @@
 #include <thread>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 #include <boost/lockfree/spsc_queue.hpp>
 #include <boost/program_options.hpp>
@@ -15,18 +16,24 @@
 #include "common/configuration.h"
 #include "common/dataformat.h"
 #include "common/local_ip.h"
+#include "common/mirror_ring.h"
 
 #ifdef HAVE_HYDRA
 	#include "launcher/hydra_launcher.hpp"
 #endif //HAVE_HYDRA
 
 #include "transport/endpoints.h"
+#include "transport/routing_table.h"
+#include "transport/tcp/tcp_tuning.h"
+
+#include "control/control_server.h"
+#include "control/control_client.h"
 
 using namespace lseb;
 
 int main(int argc, char* argv[]) {
 
-  int id;
+  int id = -1;
   std::string str_conf;
 
   boost::program_options::options_description desc("Options");
@@ -34,7 +41,10 @@ int main(int argc, char* argv[]) {
   desc.add_options()("help,h", "Print help messages.")(
     "configuration,c",
     boost::program_options::value<std::string>(&str_conf)->required(),
-    "Configuration JSON file.");
+    "Configuration JSON file.")(
+    "id,i",
+    boost::program_options::value<int>(&id),
+    "Endpoint ID (ignored with hydra).");
 
   try {
     boost::program_options::variables_map vm;
@@ -132,19 +142,282 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
+  int const sender_threads = configuration.get<int>(
+    "GENERAL.SENDER_THREADS",
+    0);
+  if (sender_threads < 0) {
+    LOG(ERROR) << "Wrong SENDER_THREADS: " << sender_threads;
+    return EXIT_FAILURE;
+  }
+
+  // Multievents in flight shared by all the destinations, 0 for a fixed
+  // window of CREDITS per destination. No window exceeds the CREDITS of the
+  // BU, so a budget of CREDITS per destination would never be shared.
+  int const nodes = endpoints.size();
+  int const credit_budget = configuration.get<int>("GENERAL.CREDIT_POOL", 0);
+  if (credit_budget && (credit_budget < nodes
+    || credit_budget >= nodes * credits)) {
+    LOG(ERROR) << "Wrong CREDIT_POOL: " << credit_budget
+               << " (between " << nodes << " and " << nodes * credits - 1
+               << ")";
+    return EXIT_FAILURE;
+  }
+
+  // Consecutive multievents for the same BU sent in a single transfer
+  int const coalesce = configuration.get<int>("GENERAL.COALESCE", 1);
+  if (coalesce < 1) {
+    LOG(ERROR) << "Wrong COALESCE: " << coalesce;
+    return EXIT_FAILURE;
+  }
+
+  // Multievents sent in pieces of up to this many bytes, 0 to send them
+  // whole. The pieces of a multievent must fit the credits of the BU: all of
+  // them but the last one hold more than BULKED_BYTES - MAX_FRAGMENT_SIZE.
+  int const bulked_bytes = configuration.get<int>("GENERAL.BULKED_BYTES", 0);
+  if (bulked_bytes < 0 || (bulked_bytes && (bulked_bytes <= max_fragment_size
+    || (credits - 1) * (bulked_bytes - max_fragment_size)
+      < max_fragment_size * bulk_size))) {
+    LOG(ERROR) << "Wrong BULKED_BYTES: " << bulked_bytes;
+    return EXIT_FAILURE;
+  }
+  if (bulked_bytes && coalesce != 1) {
+    LOG(ERROR) << "COALESCE must be 1 with BULKED_BYTES";
+    return EXIT_FAILURE;
+  }
+
+  /************** Transport routing ******************/
+
+  TransportType const remote_transport = transport_from_string(
+    configuration.get<std::string>("TRANSPORT.REMOTE", DEFAULT_TRANSPORT));
+  TransportType const local_transport = transport_from_string(
+    configuration.get<std::string>(
+      "TRANSPORT.LOCAL",
+      transport_to_string(remote_transport)));
+
+  RoutingTable const routing_table(
+    endpoints,
+    id,
+    local_transport,
+    remote_transport);
+  LOG(INFO) << "Routing table: " << routing_table;
+
+  // Speeds are given in Gb/s
+  TcpOptions tcp_options;
+  tcp_options.nodelay = configuration.get<bool>("TCP.NODELAY", true);
+  tcp_options.auto_tune = configuration.get<bool>("TCP.AUTO_TUNE", true);
+  tcp_options.notsent_lowat = configuration.get<size_t>("TCP.NOTSENT_LOWAT", 0);
+  tcp_options.pacing_rate = configuration.get<double>("TCP.PACING_RATE", 0.)
+    * std::giga::num / 8.;
+  tcp_options.link_speed = configuration.get<double>("TCP.LINK_SPEED", 0.)
+    * std::giga::num / 8.;
+  // With AUTO_TUNE the buffers follow the bandwidth-delay product when both
+  // the link speed and the round trip time are known, bounded by the data in
+  // flight allowed by the credits. Otherwise the kernel autotunes them.
+  double const tcp_rtt_us = configuration.get<double>("TCP.RTT_US", 0.);
+  if (tcp_rtt_us < 0.) {
+    LOG(ERROR) << "Wrong TCP.RTT_US: " << tcp_rtt_us;
+    return EXIT_FAILURE;
+  }
+  if (tcp_options.auto_tune) {
+    size_t const chunk_size = bulked_bytes ?
+      bulked_bytes : max_fragment_size * bulk_size * coalesce;
+    tcp_options.buffer_size = tcp_buffer_size(
+      tcp_options.link_speed,
+      tcp_rtt_us / std::micro::den,
+      chunk_size,
+      chunk_size * credits);
+  }
+
+  /************** Destination scheduler ******************/
+
+  SchedulerOptions scheduler_options;
+  scheduler_options.policy = scheduler_policy_from_string(
+    configuration.get<std::string>("SCHEDULER.POLICY", "ROUND_ROBIN"));
+  scheduler_options.slots = configuration.get<int>(
+    "SCHEDULER.SLOTS",
+    scheduler_options.slots);
+  scheduler_options.epoch_cycles = configuration.get<int>(
+    "SCHEDULER.EPOCH_CYCLES",
+    scheduler_options.epoch_cycles);
+  scheduler_options.lag = configuration.get<int>(
+    "SCHEDULER.LAG",
+    scheduler_options.lag);
+  if (scheduler_options.slots < 1 || scheduler_options.epoch_cycles < 1
+    || scheduler_options.lag < 1) {
+    LOG(ERROR) << "Wrong SCHEDULER configuration";
+    return EXIT_FAILURE;
+  }
+  if (scheduler_options.policy != SchedulerPolicy::ROUND_ROBIN
+    && scheduler_options.slots >= credits) {
+    LOG(WARNING)
+      << "SCHEDULER.SLOTS not lower than CREDITS: the RUs will proceed in lock"
+      << " step, one cycle at a time";
+  }
+
+  /************** Adaptive multievent size ******************/
+
+  // The RUs can adapt the size of the multievents, from MIN_EVENTS up to
+  // BULKED_EVENTS, to a target completion latency (us). The size changes every
+  // EPOCH_CYCLES cycles and is decided by the manager rank LAG epochs ahead.
+  bool const adaptive_bulk = configuration.get<bool>(
+    "ADAPTIVE_BULK.ENABLED",
+    false);
+  BulkOptions bulk_options;
+  bulk_options.min_events = bulk_size;
+  if (adaptive_bulk) {
+    bulk_options.min_events = configuration.get<int>(
+      "ADAPTIVE_BULK.MIN_EVENTS",
+      std::max(1, bulk_size / 8));
+    bulk_options.target_latency = configuration.get<double>(
+      "ADAPTIVE_BULK.TARGET_LATENCY_US",
+      bulk_options.target_latency * std::micro::den) / std::micro::den;
+    bulk_options.epoch_cycles = configuration.get<int>(
+      "ADAPTIVE_BULK.EPOCH_CYCLES",
+      bulk_options.epoch_cycles);
+    bulk_options.lag = configuration.get<int>(
+      "ADAPTIVE_BULK.LAG",
+      bulk_options.lag);
+    if (bulk_options.min_events < 1 || bulk_options.min_events > bulk_size
+      || bulk_options.target_latency <= 0. || bulk_options.epoch_cycles < 1
+      || bulk_options.lag < 1) {
+      LOG(ERROR) << "Wrong ADAPTIVE_BULK configuration";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // A multievent is cut short after MAX_AGE_US from the trigger of its first
+  // event (0 to always wait for BULKED_EVENTS)
+  double const max_age = configuration.get<double>("GENERAL.MAX_AGE_US", 0.)
+    / std::micro::den;
+  if (max_age < 0.) {
+    LOG(ERROR) << "Wrong MAX_AGE_US: " << max_age * std::micro::den;
+    return EXIT_FAILURE;
+  }
+
+  // The BUs find the multievents of a transfer by their size
+  bool const variable_bulk = adaptive_bulk || max_age;
+  if (variable_bulk && (coalesce != 1 || bulked_bytes)) {
+    LOG(ERROR)
+      << "COALESCE must be 1 and BULKED_BYTES 0 with ADAPTIVE_BULK or MAX_AGE_US";
+    return EXIT_FAILURE;
+  }
+
+  // The manager rank collects the load reports and distributes the
+  // assignments over the control connections
+  int const manager_id = configuration.get<int>("CONTROL.MANAGER", 0);
+  std::string const control_port = configuration.get<std::string>(
+    "CONTROL.PORT",
+    "7100");
+  if (manager_id < 0 || manager_id >= static_cast<int>(endpoints.size())) {
+    LOG(ERROR) << "Wrong CONTROL.MANAGER: " << manager_id;
+    return EXIT_FAILURE;
+  }
+
+  // The BUs can report the congestion of their sources to the RUs, through
+  // the manager rank
+  bool const congestion_feedback = configuration.get<bool>(
+    "CONGESTION.ENABLED",
+    false);
+
+  std::unique_ptr<LeastLoadedManager> manager;
+  std::unique_ptr<EventManager> event_manager;
+  std::unique_ptr<BulkManager> bulk_manager;
+  std::unique_ptr<ControlServer> control_server;
+  std::unique_ptr<ControlClient> control_client;
+  std::unique_ptr<Scheduler> scheduler;
+  if (scheduler_options.policy == SchedulerPolicy::LEAST_LOADED) {
+    if (id == manager_id) {
+      manager.reset(new LeastLoadedManager(endpoints.size(), scheduler_options));
+    }
+  } else if (scheduler_options.policy == SchedulerPolicy::EVENT_MANAGER) {
+    // A cycle is assigned only when the BUs requested enough multievents
+    if (scheduler_options.slots > credits) {
+      LOG(ERROR) << "SCHEDULER.SLOTS greater than CREDITS";
+      return EXIT_FAILURE;
+    }
+    if (id == manager_id) {
+      event_manager.reset(new EventManager(endpoints.size(), scheduler_options));
+    }
+  }
+  if (adaptive_bulk && id == manager_id) {
+    bulk_manager.reset(new BulkManager(endpoints.size(), bulk_size, bulk_options));
+  }
+  if (scheduler_options.policy != SchedulerPolicy::ROUND_ROBIN
+    || congestion_feedback || adaptive_bulk) {
+    if (id == manager_id) {
+      control_server.reset(
+        new ControlServer(
+          endpoints[manager_id].hostname(),
+          control_port,
+          endpoints.size(),
+          [&manager, &event_manager, &bulk_manager, &control_server](
+            ControlMessage const& message) {
+            ControlMessage assignment;
+            if (message.type == MessageType::CONGESTION) {
+              control_server->broadcast(message);
+            } else if (message.type == MessageType::BULK_REPORT) {
+              if (bulk_manager->add(message, assignment)) {
+                control_server->broadcast(assignment);
+              }
+            } else if (manager) {
+              if (manager->add(message, assignment)) {
+                control_server->broadcast(assignment);
+              }
+            } else if (event_manager) {
+              for (auto const& assignment : event_manager->add(message)) {
+                control_server->broadcast(assignment);
+              }
+            }
+          }));
+    }
+    control_client.reset(
+      new ControlClient(endpoints[manager_id].hostname(), control_port, id));
+  }
+  if (scheduler_options.policy == SchedulerPolicy::LEAST_LOADED) {
+    scheduler.reset(
+      new LeastLoadedScheduler(
+        *control_client,
+        endpoints.size(),
+        credits,
+        scheduler_options));
+  } else if (scheduler_options.policy == SchedulerPolicy::EVENT_MANAGER) {
+    scheduler.reset(
+      new PullScheduler(*control_client, endpoints.size(), scheduler_options));
+  } else {
+    scheduler.reset(new RoundRobinScheduler(endpoints.size(), coalesce));
+  }
+  LOG(INFO)
+    << "Scheduler: "
+    << scheduler_policy_to_string(scheduler_options.policy);
+  BulkController const bulk_controller(
+    adaptive_bulk ? control_client.get() : nullptr,
+    bulk_size,
+    bulk_options);
+
   /************** Memory allocation ******************/
 
-  int const meta_size = sizeof(EventMetaData) * bulk_size * (credits * 2 + 1);
-  int const data_size = max_fragment_size * bulk_size * (credits * 2 + 1);
+  // The RU acquires up to a whole cycle of multievents before sending them,
+  // keep room for two of them. With a credit pool the memory follows the
+  // budget, so that the windows can grow up to CREDITS where the links are
+  // fast. The rings have a power-of-two size, so the multievents drift over
+  // their end: the data buffer is mapped twice, so that the one that wraps is
+  // still contiguous.
+  int const in_flight = credit_budget ? credit_budget : credits;
+  int const multievents =
+    std::max(in_flight, scheduler->cycle_length()) * 2 + 1;
+  size_t const meta_size = sizeof(EventMetaData)
+    * next_power_of_two(bulk_size * multievents);
+  size_t const data_size = MirrorRing::round_size(
+    next_power_of_two(max_fragment_size * bulk_size * multievents));
 
   std::unique_ptr<unsigned char[]> const metadata_ptr(
     new unsigned char[meta_size]);
-  std::unique_ptr<unsigned char[]> const data_ptr(new unsigned char[data_size]);
+  MirrorRing const data_ring(data_size);
 
   MetaDataRange metadata_range(
     pointer_cast<EventMetaData>(metadata_ptr.get()),
     pointer_cast<EventMetaData>(metadata_ptr.get() + meta_size));
-  DataRange data_range(data_ptr.get(), data_ptr.get() + data_size);
+  DataRange data_range(data_ring.begin(), data_ring.end());
 
   /********* Generator, Controller and Accumulator **********/
 
@@ -162,15 +435,215 @@ int main(int argc, char* argv[]) {
     stddev,
     max_fragment_size - sizeof(EventHeader));
   Generator generator(payload_size_generator, metadata_range, data_range, id);
-  Controller controller(generator, metadata_range, generator_frequency);
+  // With THREAD the events are generated by a thread of their own, pinned to
+  // CPU if that is given
+  bool const generator_thread = configuration.get<bool>(
+    "GENERATOR.THREAD",
+    false);
+  int const generator_cpu = configuration.get<int>("GENERATOR.CPU", -1);
+  if (generator_cpu < -1 || (generator_cpu != -1 && !generator_thread)) {
+    LOG(ERROR) << "Wrong GENERATOR.CPU: " << generator_cpu
+               << " (a cpu requires GENERATOR.THREAD)";
+    return EXIT_FAILURE;
+  }
+
+  /************** Load profile ******************/
+
+  // Trigger rate over time, the same in all the RUs. FREQUENCY is the base
+  // rate, or the bunch crossing rate of a filling scheme.
+  std::unique_ptr<LoadProfile> load_profile;
+  std::string const profile_type = configuration.get<std::string>(
+    "LOAD_PROFILE.TYPE",
+    "UNIFORM");
+  if (profile_type == "UNIFORM") {
+    load_profile.reset(new LoadProfile(uniform_profile(generator_frequency)));
+  } else if (profile_type == "FILLING_SCHEME") {
+    std::string const bunches = configuration.get<std::string>(
+      "LOAD_PROFILE.BUNCHES");
+    if (bunches.find_first_not_of("01 \t\n") != std::string::npos
+      || bunches.find('1') == std::string::npos) {
+      LOG(ERROR) << "Wrong LOAD_PROFILE.BUNCHES: " << bunches;
+      return EXIT_FAILURE;
+    }
+    load_profile.reset(
+      new LoadProfile(filling_scheme_profile(bunches, generator_frequency)));
+  } else if (profile_type == "BURSTS") {
+    double const burst_frequency = configuration.get<double>(
+      "LOAD_PROFILE.BURST_FREQUENCY");
+    double const burst_rate = configuration.get<double>(
+      "LOAD_PROFILE.BURST_RATE");
+    double const burst_us = configuration.get<double>("LOAD_PROFILE.BURST_US");
+    if (burst_frequency < 0. || burst_rate <= 0. || burst_us <= 0.) {
+      LOG(ERROR) << "Wrong LOAD_PROFILE bursts: " << burst_frequency << " Hz, "
+                 << burst_rate << " bursts/s, " << burst_us << " us";
+      return EXIT_FAILURE;
+    }
+    load_profile.reset(
+      new LoadProfile(
+        burst_profile(
+          generator_frequency,
+          burst_frequency,
+          burst_rate,
+          burst_us / std::micro::den,
+          configuration.get<unsigned int>("LOAD_PROFILE.SEED", 0))));
+  } else if (profile_type == "TIMELINE") {
+    std::vector<RateSegment> segments;
+    double events = 0.;
+    for (auto const& segment : configuration.get_child("LOAD_PROFILE.TIMELINE")) {
+      double const duration_us = segment.second.get<double>("DURATION_US");
+      double const frequency = segment.second.get<double>("FREQUENCY");
+      if (duration_us <= 0. || frequency < 0.) {
+        LOG(ERROR) << "Wrong LOAD_PROFILE.TIMELINE segment: " << duration_us
+                   << " us at " << frequency << " Hz";
+        return EXIT_FAILURE;
+      }
+      segments.push_back( { duration_us / std::micro::den, frequency });
+      events += duration_us * frequency;
+    }
+    if (!events) {
+      LOG(ERROR) << "Wrong LOAD_PROFILE.TIMELINE: no events";
+      return EXIT_FAILURE;
+    }
+    load_profile.reset(new LoadProfile(segments));
+  } else {
+    LOG(ERROR) << "Wrong LOAD_PROFILE.TYPE: " << profile_type;
+    return EXIT_FAILURE;
+  }
+  LOG(INFO) << "Load profile: " << profile_type << ", mean rate "
+            << load_profile->mean_rate() << " Hz";
+
+  Controller controller(
+    generator,
+    *load_profile,
+    configuration.get<bool>("GENERATOR.SLEEP", false),
+    generator_thread);
   Accumulator accumulator(
     controller,
     metadata_range,
     data_range,
-    bulk_size);
+    bulk_size,
+    max_age ? 1 : bulk_options.min_events,
+    bulked_bytes,
+    max_age);
+
+  /************** Barrel shifter ******************/
+
+  // The slot fits a multievent of mean size at the link speed (Gb/s), unless
+  // its length is given explicitly. The capacity of a slot (the bytes sent in
+  // it at the link speed, or a multievent of mean size if unknown) caps what
+  // an RU sends in it, and is used to report its utilization.
+  double const multievent_bytes = (mean + sizeof(EventHeader)) * bulk_size;
+  std::chrono::nanoseconds barrel_slot(0);
+  double slot_bytes = multievent_bytes;
+  if (configuration.get<bool>("BARREL_SHIFTER.ENABLED", false)) {
+    double const slot_us = configuration.get<double>(
+      "BARREL_SHIFTER.SLOT_US",
+      0.);
+    double const link_speed = configuration.get<double>(
+      "BARREL_SHIFTER.LINK_SPEED",
+      configuration.get<double>("TCP.LINK_SPEED", 0.)) * std::giga::num / 8.;
+    double const guard = configuration.get<double>("BARREL_SHIFTER.GUARD", 0.1);
+    if (slot_us > 0.) {
+      barrel_slot = std::chrono::nanoseconds(
+        static_cast<int64_t>(slot_us * std::kilo::num));
+    } else if (link_speed > 0. && guard >= 0.) {
+      barrel_slot = barrel_slot_length(multievent_bytes, link_speed, guard);
+    } else {
+      LOG(ERROR) << "Wrong BARREL_SHIFTER configuration";
+      return EXIT_FAILURE;
+    }
+    if (link_speed > 0.) {
+      slot_bytes = link_speed * barrel_slot.count() / std::nano::den;
+    }
+    LOG(INFO) << "Barrel shifter slot: " << barrel_slot.count() << " ns";
+  }
+  BarrelShifter const barrel_shifter(
+    id,
+    endpoints.size(),
+    barrel_slot,
+    slot_bytes);
+
+  CreditPool const credit_pool(endpoints.size(), credits, credit_budget);
+
+  /************** Event filter ******************/
+
+  // First-level trigger applied by the RU to its fragments before sending
+  // them, sizes are payload bytes
+  std::unique_ptr<EventFilter> filter;
+  std::string const filter_type = configuration.get<std::string>(
+    "FILTER.TYPE",
+    "NONE");
+  if (filter_type == "PRESCALE") {
+    int const prescale = configuration.get<int>("FILTER.PRESCALE");
+    if (prescale < 1) {
+      LOG(ERROR) << "Wrong FILTER.PRESCALE: " << prescale;
+      return EXIT_FAILURE;
+    }
+    filter.reset(new PrescaleFilter(prescale));
+  } else if (filter_type == "SIZE_CUT") {
+    int const min_size = configuration.get<int>("FILTER.MIN_SIZE", 0);
+    int const max_size = configuration.get<int>("FILTER.MAX_SIZE", 0);
+    if (min_size < 0 || max_size < 0 || (max_size && min_size > max_size)) {
+      LOG(ERROR) << "Wrong FILTER sizes: " << min_size << "-" << max_size;
+      return EXIT_FAILURE;
+    }
+    filter.reset(new SizeCutFilter(min_size, max_size));
+  } else if (filter_type != "NONE") {
+    LOG(ERROR) << "Wrong FILTER.TYPE: " << filter_type;
+    return EXIT_FAILURE;
+  }
+
+  /************** Congestion feedback ******************/
+
+  // Every PERIOD_MS the BUs mark the sources with a standing receive queue of
+  // at least DEPTH multievents, and the RUs pace the marking BUs with token
+  // buckets of BURST multievents of mean size
+  std::chrono::nanoseconds congestion_period(0);
+  int congestion_depth = std::max(1, credits * coalesce / 2);
+  double congestion_burst = 0.;
+  if (congestion_feedback) {
+    double const period_ms = configuration.get<double>(
+      "CONGESTION.PERIOD_MS",
+      10.);
+    congestion_depth = configuration.get<int>(
+      "CONGESTION.DEPTH",
+      congestion_depth);
+    double const burst = configuration.get<double>("CONGESTION.BURST", 2.);
+    if (period_ms <= 0. || congestion_depth < 1 || burst <= 0.) {
+      LOG(ERROR) << "Wrong CONGESTION configuration";
+      return EXIT_FAILURE;
+    }
+    congestion_period = std::chrono::nanoseconds(
+      static_cast<int64_t>(period_ms * std::mega::num));
+    congestion_burst = burst * multievent_bytes;
+  }
+  CongestionMonitor const congestion_monitor(
+    endpoints.size(),
+    congestion_period,
+    congestion_depth);
+  CongestionPacer const congestion_pacer(
+    id,
+    endpoints.size(),
+    congestion_burst,
+    tcp_options.link_speed);
 
   /**************** Builder Unit and Readout Unit *****************/
 
+  // With a receive ring the memory of the BU is sized on the mean event size
+  // instead of MAX_FRAGMENT_SIZE
+  std::string const recv_mode = configuration.get<std::string>(
+    "GENERAL.RECV_MODE",
+    "CHUNKS");
+  size_t recv_ring_size = 0;
+  if (recv_mode == "RING") {
+    recv_ring_size = std::max<size_t>(
+      (mean + sizeof(EventHeader)) * bulk_size * credits * coalesce,
+      std::max(max_fragment_size * bulk_size * coalesce, bulked_bytes));
+  } else if (recv_mode != "CHUNKS") {
+    LOG(ERROR) << "Wrong RECV_MODE: " << recv_mode;
+    return EXIT_FAILURE;
+  }
+
   boost::lockfree::spsc_queue<iovec> free_local_data(credits);
   boost::lockfree::spsc_queue<iovec> ready_local_data(credits);
 
@@ -178,18 +651,42 @@ int main(int argc, char* argv[]) {
     free_local_data,
     ready_local_data,
     endpoints,
+    routing_table,
+    tcp_options,
     bulk_size,
+    bulked_bytes,
+    variable_bulk,
     credits,
     max_fragment_size,
+    recv_ring_size,
+    coalesce,
+    (scheduler_options.policy == SchedulerPolicy::EVENT_MANAGER) ?
+      control_client.get() :
+      nullptr,
+    congestion_monitor,
+    congestion_feedback ? control_client.get() : nullptr,
     id);
 
   ReadoutUnit ru(
     accumulator,
+    *scheduler,
+    bulk_controller,
+    barrel_shifter,
+    credit_pool,
+    filter.get(),
+    congestion_pacer,
+    congestion_feedback ? control_client.get() : nullptr,
     free_local_data,
     ready_local_data,
     endpoints,
+    routing_table,
+    tcp_options,
     bulk_size,
+    bulked_bytes,
     credits,
+    max_fragment_size,
+    sender_threads,
+    coalesce,
     id);
 
   std::shared_ptr<std::atomic<bool> > stop(new std::atomic<bool>(false));
@@ -200,6 +697,13 @@ int main(int argc, char* argv[]) {
 
   std::thread bu_th(&BuilderUnit::operator(), &bu, stop);
   std::thread ru_th(&ReadoutUnit::operator(), &ru, stop);
+  std::thread generator_th;
+  if (generator_thread) {
+    generator_th = std::thread(&Controller::operator(), &controller, stop);
+    if (generator_cpu != -1 && !pin_thread(generator_th, generator_cpu)) {
+      LOG(WARNING) << "Generator thread not pinned to cpu " << generator_cpu;
+    }
+  }
 
   // sigemptyset(&set);
   // sigaddset(&set, SIGINT);
@@ -214,6 +718,9 @@ int main(int argc, char* argv[]) {
 
   bu_th.join();
   ru_th.join();
+  if (generator_th.joinable()) {
+    generator_th.join();
+  }
 
   return EXIT_SUCCESS;
 }
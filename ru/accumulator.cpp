@@ -8,72 +8,128 @@
 namespace lseb {
 
 Accumulator::Accumulator(
-  Controller const& controller,
+  Controller& controller,
   MetaDataRange const& metadata_range,
   DataRange const& data_range,
-  int events_in_multievent)
+  int events_in_multievent,
+  int min_events_in_multievent,
+  size_t byte_budget,
+  double max_age)
     :
       m_controller(controller),
-      m_metadata_range(metadata_range),
-      m_data_range(data_range),
-      m_current_metadata(std::begin(m_metadata_range)),
+      m_metadata(
+        const_cast<EventMetaData*>(std::begin(metadata_range)),
+        const_cast<EventMetaData*>(std::end(metadata_range))),
+      m_data(
+        const_cast<unsigned char*>(std::begin(data_range)),
+        const_cast<unsigned char*>(std::end(data_range))),
       m_events_in_multievent(events_in_multievent),
+      m_min_events_in_multievent(min_events_in_multievent),
+      m_byte_budget(byte_budget),
+      m_max_age(max_age),
       m_generated_events(0),
-      m_release_metadata(std::begin(m_metadata_range)) {
+      m_multievent_events(0),
+      m_cut_events(0),
+      m_next_event(0),
+      m_released(
+        m_metadata.size() / (byte_budget ? 1 : min_events_in_multievent) + 1,
+        false),
+      m_events(m_released.size(), 0),
+      m_next_sequence(0),
+      m_first_unreleased(0) {
+  assert(
+    m_min_events_in_multievent > 0
+      && m_min_events_in_multievent <= m_events_in_multievent);
 }
 
-bool Accumulator::checkDataWrap(MetaDataRange multievent_metadata){
-  uint64_t first_offset = std::begin(multievent_metadata)->offset;
-  auto it =
-    find_in_range(
-      multievent_metadata,
-      m_metadata_range,
-      [first_offset](EventMetaData const& m) {return (m.offset < first_offset) ? true : false;});
-  return it != std::end(multievent_metadata);
+void Accumulator::set_events_in_multievent(int events) {
+  assert(events >= m_min_events_in_multievent && !m_cut_events);
+  m_events_in_multievent = events;
+  m_multievent_events = 0;
 }
 
-std::pair<iovec, bool> Accumulator::get_multievent() {
-
-  // If not enough data ready, read data from the Controller
-  if (m_generated_events < m_events_in_multievent) {
-    MetaDataRange meta = m_controller.read();
-    m_generated_events += distance_in_range(meta, m_metadata_range);
+// Returns the number of events of the multievent starting with the next event,
+// or 0 if it is not known yet. With a maximum age, the multievent ends before
+// the first event triggered later than that after its first one: the trigger
+// schedule and the events already cut are the same in all the RUs, and so are
+// the multievents.
+int Accumulator::multieventEvents() {
+  if (!m_max_age) {
+    return m_events_in_multievent;
   }
+  if (!m_generated_events) {
+    return 0;
+  }
+  uint64_t const window = m_controller.events_before(
+    m_controller.trigger_time(m_next_event) + m_max_age) - m_next_event;
+  return std::max<uint64_t>(
+    1,
+    std::min<uint64_t>(m_events_in_multievent, window));
+}
 
-  std::pair<iovec, bool> p;
-
-  if (m_generated_events >= m_events_in_multievent) {
-
-  // Create bulked metadata and data ranges
-  MetaDataRange multievent_metadata(
-    m_current_metadata,
-    advance_in_range(
-      m_current_metadata,
-      m_events_in_multievent,
-      m_metadata_range));
-
-  // Check for wrap
-  bool wrap = checkDataWrap(multievent_metadata);
-  assert(wrap == 0 && "Wrap found!");
+// Returns the number of events of the next piece of the current multievent,
+// or 0 if more events are needed to know where it ends: a piece ends with the
+// multievent or before the first event that does not fit the byte budget (it
+// has at least one event)
+int Accumulator::cutPiece() {
+  if (!m_multievent_events) {
+    m_multievent_events = multieventEvents();
+    if (!m_multievent_events) {
+      return 0;
+    }
+  }
+  int const left = m_multievent_events - m_cut_events;
+  if (!m_byte_budget) {
+    return m_generated_events >= left ? left : 0;
+  }
+  size_t bytes = 0;
+  for (int events = 0; events < left; ++events) {
+    if (events == m_generated_events) {
+      return 0;
+    }
+    bytes += m_metadata[m_next_event + events].length;
+    if (events && bytes > m_byte_budget) {
+      return events;
+    }
+  }
+  return left;
+}
 
-  // Find data begin
-  auto data_begin = std::begin(m_data_range) + multievent_metadata.begin()
-    ->offset;
+std::pair<Multievent, bool> Accumulator::get_multievent() {
 
-  // Find data end
-  auto last_metadata = advance_in_range(
-    std::end(multievent_metadata),
-    -1,
-    m_metadata_range);
-  auto data_end =
-    std::begin(m_data_range) + last_metadata->offset + last_metadata->length;
+  // If not enough data ready, read data from the Controller
+  int events = cutPiece();
+  if (!events) {
+    m_generated_events += m_controller.read();
+    events = cutPiece();
+  }
 
-  p.first = { data_begin, (size_t) std::distance(data_begin, data_end) };
-  m_iov_multievents.emplace_back(p.first.iov_base, false);
+  std::pair<Multievent, bool> p;
+
+  if (events) {
+
+  // A multievent that wraps around the end of the data buffer continues in
+  // its second mapping
+  EventMetaData const& first = m_metadata[m_next_event];
+  EventMetaData const& last = m_metadata[m_next_event + events - 1];
+  p.first.iov = {
+    m_data.begin() + first.offset,
+    m_data.offset(last.offset - first.offset) + last.length };
+
+  m_cut_events += events;
+  m_next_event += events;
+  p.first.events = events;
+  p.first.last = m_cut_events == m_multievent_events;
+  if (p.first.last) {
+    m_cut_events = 0;
+    m_multievent_events = 0;
+  }
+  m_events[m_next_sequence % m_events.size()] = events;
+  p.first.sequence = m_next_sequence++;
+  assert(m_next_sequence - m_first_unreleased <= m_released.size());
   p.second = true;
 
-  m_generated_events -= m_events_in_multievent;
-  m_current_metadata = std::end(multievent_metadata);
+  m_generated_events -= events;
 
   LOG(DEBUG) << "Accumulator - Acquired 1 multievent";
   }
@@ -85,40 +141,28 @@ std::pair<iovec, bool> Accumulator::get_multievent() {
 }
 
 int Accumulator::releaseContiguousMemory() {
-  auto it = std::find_if(
-    std::begin(m_iov_multievents),
-    std::end(m_iov_multievents),
-    [](std::pair<void*, bool> const& p) {return p.second == false;});
-  int multievents_to_release = std::distance(std::begin(m_iov_multievents), it);
-  assert(multievents_to_release >= 0);
+  int multievents_to_release = 0;
+  int events_to_release = 0;
+  while (m_first_unreleased != m_next_sequence
+    && m_released[m_first_unreleased % m_released.size()]) {
+    m_released[m_first_unreleased % m_released.size()] = false;
+    events_to_release += m_events[m_first_unreleased % m_events.size()];
+    ++m_first_unreleased;
+    ++multievents_to_release;
+  }
   if (multievents_to_release) {
-    MetaDataRange metadata_to_release(
-      m_release_metadata,
-      advance_in_range(
-        m_release_metadata,
-        m_events_in_multievent * multievents_to_release,
-        m_metadata_range));
-    m_release_metadata = std::end(metadata_to_release);
-    m_controller.release(metadata_to_release);
-    m_iov_multievents.erase(
-      std::begin(m_iov_multievents),
-      std::begin(m_iov_multievents) + multievents_to_release);
+    m_controller.release(events_to_release);
     LOG(DEBUG) << "Accumulator - Released " << multievents_to_release
                << " contiguous multievents";
   }
   return multievents_to_release;
 }
 
-void Accumulator::release_multievents(std::vector<void*> const& vect) {
-  for (auto& addr : vect) {
-    auto it =
-      std::find_if(
-        std::begin(m_iov_multievents),
-        std::end(m_iov_multievents),
-        [&addr] (std::pair<void*, bool> const& p) {return p.first == addr;});
-    assert(it != std::end(m_iov_multievents));
-    assert(it->second == false);
-    it->second = true;
+void Accumulator::release_multievents(std::vector<uint64_t> const& sequences) {
+  for (auto sequence : sequences) {
+    assert(sequence >= m_first_unreleased && sequence < m_next_sequence);
+    assert(!m_released[sequence % m_released.size()]);
+    m_released[sequence % m_released.size()] = true;
   }
   releaseContiguousMemory();
 }
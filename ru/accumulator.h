@@ -1,8 +1,11 @@
 #ifndef RU_ACCUMULATOR_H
 #define RU_ACCUMULATOR_H
 
-#include <deque>
 #include <utility>
+#include <vector>
+
+#include <cstdint>
+#include <sys/uio.h>
 
 #include "common/dataformat.h"
 
@@ -10,29 +13,65 @@
 
 namespace lseb {
 
+// A multievent acquired from the Accumulator, released by sequence number. It
+// is always contiguous: the data buffer is mapped twice (see MirrorRing) and a
+// multievent that wraps around its end continues in the second mapping, which
+// must be accessible for twice the size of the data range. Events are never
+// split.
+// With a byte budget, a multievent is acquired in pieces of up to that many
+// bytes: last marks the one that completes the multievent. With a maximum age,
+// a multievent holds only the events triggered within that time from its first
+// one, so that it is not held back at low trigger rates.
+struct Multievent {
+  iovec iov;
+  uint64_t sequence;
+  int events;
+  bool last;
+};
+
+// Multievents are acquired in order and can be released in any order, but
+// their memory is given back to the Controller only when contiguous. The
+// multievents in flight are tracked in a ring indexed by sequence number, so
+// that a release is O(1) amortized. Events are addressed by their number in
+// the metadata ring, whose size is a power of two like the one of the data
+// ring (see Ring).
 class Accumulator {
-  Controller m_controller;
-  MetaDataRange m_metadata_range;
-  DataRange m_data_range;
-  MetaDataRange::iterator m_current_metadata;
+  Controller& m_controller;
+  Ring<EventMetaData> m_metadata;
+  Ring<unsigned char> m_data;
   int m_events_in_multievent;
+  int m_min_events_in_multievent;
+  size_t m_byte_budget;
+  double m_max_age;
   int m_generated_events;
-  std::deque<std::pair<void*, bool> > m_iov_multievents;
-  MetaDataRange::iterator m_release_metadata;
+  int m_multievent_events;
+  int m_cut_events;
+  uint64_t m_next_event;
+  std::vector<bool> m_released;
+  std::vector<int> m_events;
+  uint64_t m_next_sequence;
+  uint64_t m_first_unreleased;
 
-  bool checkDataWrap(MetaDataRange multievent_metadata);
   int releaseContiguousMemory();
+  int multieventEvents();
+  int cutPiece();
 
  public:
   Accumulator(
-    Controller const& controller,
+    Controller& controller,
     MetaDataRange const& metadata_range,
     DataRange const& data_range,
-    int events_in_multievent);
-  std::pair<iovec, bool> get_multievent();
-  void release_multievents(std::vector<void*> const& vect);
+    int events_in_multievent,
+    int min_events_in_multievent,
+    size_t byte_budget,
+    double max_age);
+  // Events in the next multievents, at least min_events_in_multievent. The
+  // size changes only between multievents, not within the pieces of one.
+  void set_events_in_multievent(int events);
+  std::pair<Multievent, bool> get_multievent();
+  void release_multievents(std::vector<uint64_t> const& sequences);
   DataRange data_range() {
-    return m_data_range;
+    return DataRange(m_data.begin(), m_data.end());
   }
 };
 
@@ -0,0 +1,96 @@
+#include "ru/barrel_shifter.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <cassert>
+
+namespace lseb {
+
+BarrelShifter::BarrelShifter(
+  int id,
+  int nodes,
+  std::chrono::nanoseconds slot_length,
+  double slot_bytes)
+    :
+      m_id(id),
+      m_nodes(nodes),
+      m_slot_length(slot_length),
+      m_slot_bytes(slot_bytes),
+      m_first_slot(0),
+      m_last_used_slot(0),
+      m_used_slots(0),
+      m_bytes(0),
+      m_slot_sent(0) {
+  assert(m_slot_length.count() >= 0);
+  if (enabled()) {
+    m_first_slot = current_slot();
+    m_last_used_slot = m_first_slot - 1;
+  }
+}
+
+uint64_t BarrelShifter::current_slot() const {
+  auto const now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch());
+  return now.count() / m_slot_length.count();
+}
+
+double BarrelShifter::available(int destination) const {
+  if (!enabled() || destination == m_id) {
+    return std::numeric_limits<double>::infinity();
+  }
+  uint64_t const slot = current_slot();
+  int const target = (m_id + slot) % m_nodes;
+  if (destination != target) {
+    return 0.;
+  }
+  if (slot != m_last_used_slot) {
+    return m_slot_bytes;
+  }
+  return std::max(0., m_slot_bytes - m_slot_sent);
+}
+
+void BarrelShifter::sent(int destination, size_t bytes) {
+  if (enabled() && destination != m_id) {
+    uint64_t const slot = current_slot();
+    if (slot != m_last_used_slot) {
+      m_last_used_slot = slot;
+      ++m_used_slots;
+      m_slot_sent = 0;
+    }
+    m_slot_sent += bytes;
+    m_bytes += bytes;
+  }
+}
+
+std::pair<double, double> BarrelShifter::utilization() {
+  if (!enabled()) {
+    return std::make_pair(0., 0.);
+  }
+  uint64_t const slot = current_slot();
+  // One slot out of N is reserved to the local BU
+  double const remote_slots = (slot - m_first_slot) * (m_nodes - 1.)
+    / m_nodes;
+  std::pair<double, double> const p =
+      remote_slots > 0. ?
+        std::make_pair(
+          m_used_slots / remote_slots,
+          m_bytes / (remote_slots * m_slot_bytes)) :
+        std::make_pair(0., 0.);
+  m_first_slot = slot;
+  m_used_slots = 0;
+  m_bytes = 0;
+  return p;
+}
+
+std::chrono::nanoseconds barrel_slot_length(
+  double multievent_bytes,
+  double link_speed,
+  double guard) {
+  assert(link_speed > 0. && guard >= 0.);
+  return std::chrono::nanoseconds(
+    static_cast<int64_t>(
+      multievent_bytes / link_speed * (1. + guard) * std::nano::den));
+}
+
+}
@@ -0,0 +1,66 @@
+#ifndef RU_BARREL_SHIFTER_H
+#define RU_BARREL_SHIFTER_H
+
+#include <chrono>
+#include <utility>
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace lseb {
+
+// Time-slotted traffic shaping. Time is divided in slots of the same length
+// on all the nodes, counted from the epoch of the system clock (which is
+// therefore expected to be synchronized, e.g. by PTP), and during slot s the
+// RU i sends only to the BU (i + s) mod N. Every BU is then the target of a
+// single RU at a time. A slot carries at most slot_bytes (at least one
+// transfer), so that a transfer started in a slot does not overrun the next
+// one by much. The local BU does not use the network and is never gated.
+class BarrelShifter {
+  int m_id;
+  int m_nodes;
+  std::chrono::nanoseconds m_slot_length;
+  double m_slot_bytes;
+  uint64_t m_first_slot;
+  uint64_t m_last_used_slot;
+  uint64_t m_used_slots;
+  size_t m_bytes;
+  size_t m_slot_sent;
+
+ public:
+  // A null slot length disables the shaping
+  BarrelShifter(
+    int id,
+    int nodes,
+    std::chrono::nanoseconds slot_length,
+    double slot_bytes);
+  bool enabled() const {
+    return m_slot_length.count() != 0;
+  }
+  std::chrono::nanoseconds slot_length() const {
+    return m_slot_length;
+  }
+  uint64_t current_slot() const;
+  // Bytes that can still be sent to the destination in the current slot
+  double available(int destination) const;
+  // Whether the destination can be sent to in the current slot: it is the
+  // target of the slot and the slot has room left
+  bool allowed(int destination) const {
+    return available(destination) > 0.;
+  }
+  void sent(int destination, size_t bytes);
+  // Fraction of the remote slots used and fraction of their capacity
+  // (slot_bytes each) filled since the last call
+  std::pair<double, double> utilization();
+};
+
+// Time needed to send a multievent of the given size at the link speed
+// (bytes/s), with some guard time
+std::chrono::nanoseconds barrel_slot_length(
+  double multievent_bytes,
+  double link_speed,
+  double guard);
+
+}
+
+#endif
@@ -0,0 +1,130 @@
+#include "ru/bulk_controller.h"
+
+#include <algorithm>
+#include <ratio>
+
+#include <cassert>
+#include <cmath>
+
+#include "common/log.hpp"
+
+namespace lseb {
+
+namespace {
+
+// Bounds of the change of the multievent size in an epoch
+double const min_step = 0.5;
+double const max_step = 2.;
+
+}
+
+BulkController::BulkController(
+  ControlClient* control,
+  int bulk_size,
+  BulkOptions const& options)
+    :
+      m_control(control),
+      m_bulk_size(bulk_size),
+      m_options(options),
+      m_next_report(0),
+      m_latency(0.),
+      m_completed(0) {
+  assert(m_options.min_events > 0 && m_options.min_events <= m_bulk_size);
+  assert(m_options.epoch_cycles > 0 && m_options.lag > 0);
+  // The first epochs are cut before any latency is known
+  for (int e = 0; e < m_options.lag; ++e) {
+    m_sizes[e] = m_bulk_size;
+  }
+}
+
+// Values of a report: mean latency (ns) and number of completed transfers
+void BulkController::report(uint64_t epoch) {
+  std::vector<uint64_t> values;
+  values.push_back(m_completed ? m_latency / m_completed * std::nano::den : 0);
+  values.push_back(m_completed);
+  m_control->send(MessageType::BULK_REPORT, epoch, values);
+  m_latency = 0.;
+  m_completed = 0;
+}
+
+bool BulkController::size(uint64_t cycle, int& events) {
+  if (!enabled()) {
+    events = m_bulk_size;
+    return true;
+  }
+  uint64_t const epoch = cycle / m_options.epoch_cycles;
+  if (epoch == m_next_report) {
+    report(epoch);
+    ++m_next_report;
+  }
+
+  for (auto const& message : m_control->poll(MessageType::BULK_SIZE)) {
+    assert(message.values.size() == 1);
+    m_sizes[message.epoch] = message.values.front();
+  }
+
+  auto it = m_sizes.find(epoch);
+  if (it == std::end(m_sizes)) {
+    return false;
+  }
+  // Sizes of the previous epochs are not needed anymore
+  m_sizes.erase(std::begin(m_sizes), it);
+  events = it->second;
+  return true;
+}
+
+void BulkController::completed(double latency) {
+  m_latency += latency;
+  ++m_completed;
+}
+
+BulkManager::BulkManager(int nodes, int bulk_size, BulkOptions const& options)
+    :
+      m_nodes(nodes),
+      m_bulk_size(bulk_size),
+      m_options(options),
+      m_size(bulk_size) {
+}
+
+bool BulkManager::add(ControlMessage const& report, ControlMessage& size) {
+  assert(report.type == MessageType::BULK_REPORT);
+  assert(report.values.size() == 2);
+  auto& reports = m_reports[report.epoch];
+  reports.push_back(report);
+  if (reports.size() != static_cast<size_t>(m_nodes)) {
+    return false;
+  }
+
+  // The slowest RU sets the pace of event building
+  double latency = 0.;
+  for (auto const& r : reports) {
+    if (r.values[1]) {
+      latency = std::max(latency, r.values[0] / double(std::nano::den));
+    }
+  }
+  m_reports.erase(report.epoch);
+
+  // An epoch without measures keeps the size
+  if (latency > 0.) {
+    double const step = std::sqrt(m_options.target_latency / latency);
+    m_size *= std::min(max_step, std::max(min_step, step));
+    m_size = std::min<double>(
+      m_bulk_size,
+      std::max<double>(m_options.min_events, m_size));
+  }
+
+  size.type = MessageType::BULK_SIZE;
+  size.source = report.source;
+  size.epoch = report.epoch + m_options.lag;
+  size.values.assign(1, std::lround(m_size));
+
+  LOG(DEBUG)
+    << "Bulk manager - Multievents of epoch "
+    << size.epoch
+    << ": "
+    << size.values.front()
+    << " events";
+  return true;
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef RU_BULK_CONTROLLER_H
+#define RU_BULK_CONTROLLER_H
+
+#include <map>
+#include <vector>
+
+#include <cstdint>
+
+#include "control/control.h"
+#include "control/control_client.h"
+
+namespace lseb {
+
+struct BulkOptions {
+  int min_events;  // smallest multievent (the largest one is BULKED_EVENTS)
+  double target_latency;  // seconds, completion latency of a multievent
+  int epoch_cycles;  // cycles sharing the same multievent size
+  int lag;  // epochs between a latency report and the size based on it
+  BulkOptions()
+      :
+        min_events(1),
+        target_latency(1e-3),
+        epoch_cycles(64),
+        lag(2) {
+  }
+};
+
+// Chooses the number of events of the multievents of each cycle. All the RUs
+// must cut the same events in their multievents, so the size changes only at
+// the start of an epoch and is announced in advance by the manager rank: the
+// RUs report the completion latency of each epoch, and the manager answers
+// with the size used lag epochs later (see BulkManager). Without a control
+// connection the size is fixed.
+class BulkController {
+  ControlClient* m_control;
+  int m_bulk_size;
+  BulkOptions m_options;
+  std::map<uint64_t, int> m_sizes;
+  uint64_t m_next_report;
+  double m_latency;
+  int m_completed;
+  void report(uint64_t epoch);
+
+ public:
+  BulkController(
+    ControlClient* control,
+    int bulk_size,
+    BulkOptions const& options);
+  bool enabled() const {
+    return m_control;
+  }
+  // Events of the multievents of the cycle, false if not known yet
+  bool size(uint64_t cycle, int& events);
+  // A transfer is completed after latency seconds
+  void completed(double latency);
+};
+
+// Runs on the manager rank. When the reports of an epoch have been received
+// from all the ranks, it scales the multievent size by the square root of the
+// ratio between the target latency and the worst latency reported, within
+// [min_events, bulk_size]: multievents grow (and their overhead shrinks) as
+// long as they meet the target.
+class BulkManager {
+  int m_nodes;
+  int m_bulk_size;
+  BulkOptions m_options;
+  std::map<uint64_t, std::vector<ControlMessage> > m_reports;
+  double m_size;
+
+ public:
+  BulkManager(int nodes, int bulk_size, BulkOptions const& options);
+  // Returns true when a size is ready to be broadcast
+  bool add(ControlMessage const& report, ControlMessage& size);
+};
+
+}
+
+#endif
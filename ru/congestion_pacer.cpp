@@ -0,0 +1,114 @@
+#include "ru/congestion_pacer.h"
+
+#include <algorithm>
+
+#include <cassert>
+
+namespace lseb {
+
+namespace {
+
+// Weight of a feedback in alpha
+double const alpha_gain = 1. / 16.;
+// Additive increase of the rate at each feedback without mark, as a fraction
+// of the ceiling
+double const rate_increase = 1. / 16.;
+// The rate is never cut below this fraction of the ceiling
+double const min_rate = 1. / 64.;
+
+}
+
+double congestion_fill_ratio(std::vector<uint64_t> const& values, int source) {
+  assert(values.size() % 3 == 0 && 3 * source < static_cast<int>(values.size()));
+  uint64_t max_fill_time = 0;
+  for (size_t i = 2; i < values.size(); i += 3) {
+    max_fill_time = std::max(max_fill_time, values[i]);
+  }
+  uint64_t const fill_time = values[3 * source + 2];
+  return (fill_time && max_fill_time) ?
+    static_cast<double>(fill_time) / max_fill_time : 1.;
+}
+
+CongestionPacer::CongestionPacer(
+  int id,
+  int nodes,
+  double burst,
+  double link_speed)
+    :
+      m_id(id),
+      m_burst(burst),
+      m_link_speed(link_speed),
+      m_rate(nodes, 0.),
+      m_ceiling(nodes, 0.),
+      m_alpha(nodes, 1.),
+      m_tokens(nodes, burst),
+      m_refill_time(nodes, Clock::now()),
+      m_bytes(nodes, 0),
+      m_feedback_time(nodes, Clock::now()) {
+  assert(m_burst >= 0.);
+}
+
+// Tokens can go negative by the size of the last transfer, so that transfers
+// larger than the burst are still sent
+bool CongestionPacer::allowed(int destination, Clock::time_point now) {
+  if (!m_rate[destination]) {
+    return true;
+  }
+  double& tokens = m_tokens[destination];
+  tokens = std::min(
+    m_burst,
+    tokens + m_rate[destination] * std::chrono::duration<double>(
+      now - m_refill_time[destination]).count());
+  m_refill_time[destination] = now;
+  return tokens > 0.;
+}
+
+void CongestionPacer::sent(int destination, size_t bytes) {
+  m_bytes[destination] += bytes;
+  if (m_rate[destination]) {
+    m_tokens[destination] -= bytes;
+  }
+}
+
+void CongestionPacer::feedback(
+  int destination,
+  bool marked,
+  double fill_ratio,
+  Clock::time_point now) {
+  if (!enabled() || destination == m_id) {
+    return;
+  }
+  double const elapsed = std::chrono::duration<double>(
+    now - m_feedback_time[destination]).count();
+  double const measured = elapsed > 0. ? m_bytes[destination] / elapsed : 0.;
+  m_bytes[destination] = 0;
+  m_feedback_time[destination] = now;
+
+  double& alpha = m_alpha[destination];
+  alpha += alpha_gain * ((marked ? 1. : 0.) - alpha);
+
+  double& rate = m_rate[destination];
+  double& ceiling = m_ceiling[destination];
+  if (marked) {
+    if (!rate) {
+      // Start pacing from the current rate, brought down to the pace of the
+      // slowest source of the BU
+      if (!measured) {
+        return;
+      }
+      assert(fill_ratio > 0. && fill_ratio <= 1.);
+      ceiling = m_link_speed ? m_link_speed : measured;
+      rate = std::max(min_rate * ceiling, std::min(ceiling, measured * fill_ratio));
+      m_tokens[destination] = m_burst;
+      m_refill_time[destination] = now;
+    }
+    rate = std::max(min_rate * ceiling, rate * (1. - alpha / 2.));
+  } else if (rate) {
+    rate += rate_increase * ceiling;
+    if (rate >= ceiling) {
+      rate = 0.;
+    }
+  }
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef RU_CONGESTION_PACER_H
+#define RU_CONGESTION_PACER_H
+
+#include <chrono>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace lseb {
+
+// Fill time of the buffers of a source at a BU over the longest fill time
+// among its sources, from the values of a CONGESTION message (1 if unknown).
+// The BU builds at the pace of the source that fills its buffers last, so a
+// source with a lower ratio delivers ahead of it by that factor.
+double congestion_fill_ratio(std::vector<uint64_t> const& values, int source);
+
+// Paces the RU towards each destination with a token bucket driven by the
+// congestion feedback of the BUs (see CongestionMonitor). A destination is
+// not paced until it marks this RU as congested: its rate then starts from
+// the one measured since the previous feedback, scaled by the fill ratio (see
+// congestion_fill_ratio), and, as in DCTCP, is cut by alpha / 2 at each mark,
+// alpha being the smoothed fraction of marked feedback. Without marks the rate
+// grows additively, and the destination is no longer paced once it is back to
+// its ceiling (the link speed, if known, or the rate measured at the first
+// mark). The local BU does not use the network and is never paced.
+class CongestionPacer {
+ public:
+  using Clock = std::chrono::high_resolution_clock;
+
+ private:
+  int m_id;
+  double m_burst;
+  double m_link_speed;
+  std::vector<double> m_rate;
+  std::vector<double> m_ceiling;
+  std::vector<double> m_alpha;
+  std::vector<double> m_tokens;
+  std::vector<Clock::time_point> m_refill_time;
+  std::vector<size_t> m_bytes;
+  std::vector<Clock::time_point> m_feedback_time;
+
+ public:
+  // A null burst disables the pacing, speeds are in bytes/s (0 if unknown)
+  CongestionPacer(int id, int nodes, double burst, double link_speed);
+  bool enabled() const {
+    return m_burst != 0.;
+  }
+  // Rate of the destination in bytes/s, 0 if not paced
+  double rate(int destination) const {
+    return m_rate[destination];
+  }
+  // Whether the destination can be sent to (its bucket is not empty)
+  bool allowed(int destination, Clock::time_point now);
+  bool allowed(int destination) {
+    return allowed(destination, Clock::now());
+  }
+  void sent(int destination, size_t bytes);
+  void feedback(
+    int destination,
+    bool marked,
+    double fill_ratio,
+    Clock::time_point now);
+};
+
+}
+
+#endif
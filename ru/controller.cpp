@@ -1,53 +1,106 @@
 #include "ru/controller.h"
 
 #include <chrono>
-#include<thread>
+#include <thread>
 
 #include "common/utility.h"
 #include "common/log.hpp"
 
 namespace lseb {
 
+namespace {
+
+// The counts are summed by the consumer, a full queue only delays them
+size_t const controller_queue_size = 1024;
+
+}
+
 Controller::Controller(
   Generator const& generator,
-  MetaDataRange const& metadata_range,
-  size_t generator_frequency)
+  LoadProfile const& profile,
+  bool sleep,
+  bool thread)
     :
       m_generator(generator),
-      m_metadata_range(metadata_range),
-      m_current_metadata(std::begin(m_metadata_range)),
-      m_start_time(std::chrono::high_resolution_clock::now()),
-      m_generator_frequency(generator_frequency),
-      m_generated_events(0) {
+      m_start_time(std::chrono::steady_clock::now()),
+      m_profile(profile),
+      m_generated_events(0),
+      m_sleep(sleep),
+      m_thread(thread),
+      m_ready_queue(controller_queue_size),
+      m_release_queue(controller_queue_size) {
 }
 
-MetaDataRange Controller::read() {
+size_t Controller::read() {
+  if (!m_thread) {
+    return generate();
+  }
+  uint64_t events = 0;
+  m_ready_queue.consume_all([&events](uint64_t n) {events += n;});
+  return events;
+}
+
+void Controller::operator()(std::shared_ptr<std::atomic<bool> > stop) {
+  assert(m_thread);
+  uint64_t generated = 0;
+  uint64_t released = 0;
+  while (!(*stop)) {
+    m_release_queue.consume_all([&released](uint64_t n) {released += n;});
+    if (released) {
+      m_generator.releaseEvents(released);
+      released = 0;
+    }
+    generated += generate();
+    if (generated && m_ready_queue.push(generated)) {
+      generated = 0;
+    }
+  }
+}
 
-  double const elapsed_seconds = std::chrono::duration<double>(
-    std::chrono::high_resolution_clock::now() - m_start_time).count();
+size_t Controller::generate() {
 
-  std::this_thread::sleep_for(
-    std::chrono::microseconds(std::mega::num / m_generator_frequency));
+  auto const now = std::chrono::steady_clock::now();
+  double const elapsed_seconds =
+    std::chrono::duration<double>(now - m_start_time).count();
 
-  size_t const events_to_generate = elapsed_seconds * m_generator_frequency;
+  size_t const events_to_generate = events_before(elapsed_seconds);
   assert(events_to_generate >= m_generated_events);
 
   size_t const current_generated_events = m_generator.generateEvents(
     events_to_generate - m_generated_events);
-  auto previous_metadata = m_current_metadata;
-  m_current_metadata = advance_in_range(
-    m_current_metadata,
-    current_generated_events,
-    m_metadata_range);
   m_generated_events += current_generated_events;
-  return MetaDataRange(previous_metadata, m_current_metadata);
+
+  if (m_sleep && !current_generated_events) {
+    auto const next_event = m_start_time
+      + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(trigger_time(m_generated_events)));
+    if (next_event > now) {
+      std::this_thread::sleep_until(next_event);
+    } else {
+      std::this_thread::sleep_for(
+        std::chrono::duration<double>(1. / m_profile.mean_rate()));
+    }
+  }
+
+  return current_generated_events;
+}
+
+double Controller::trigger_time(uint64_t event) const {
+  return m_profile.trigger_time(event);
+}
+
+uint64_t Controller::events_before(double time) const {
+  return m_profile.events_before(time);
 }
 
-void Controller::release(MetaDataRange metadata_range) {
-  size_t const events_to_release = distance_in_range(
-    metadata_range,
-    m_metadata_range);
-  m_generator.releaseEvents(events_to_release);
+void Controller::release(size_t events) {
+  if (!m_thread) {
+    m_generator.releaseEvents(events);
+    return;
+  }
+  while (!m_release_queue.push(events)) {
+    ;
+  }
 }
 
 }
@@ -1,29 +1,59 @@
 #ifndef RU_CONTROLLER_H
 #define RU_CONTROLLER_H
 
+#include <atomic>
 #include <chrono>
+#include <memory>
+
+#include <boost/lockfree/spsc_queue.hpp>
 
 #include "common/dataformat.h"
 #include "generator/generator.h"
+#include "generator/load_profile.h"
 
 namespace lseb {
 
+// Events are triggered from the start following the load profile: the events
+// due and not generated yet are the tokens of a bucket that fills at the rate
+// of the profile. A read generates as many of them as the Generator has room
+// for and returns at once. With sleep, a read that has nothing to generate
+// waits until the next event is due (or for one mean period if the Generator
+// is full), leaving the core to other threads.
+//
+// With a generator thread, the events are generated by operator() as a
+// readout board would do, independently of the Readout Unit: the number of
+// events generated and released are handed over through two lock-free
+// queues, and read and release never touch the Generator.
 class Controller {
 
   Generator m_generator;
-  MetaDataRange m_metadata_range;
-  MetaDataRange::iterator m_current_metadata;
-  std::chrono::high_resolution_clock::time_point m_start_time;
-  size_t m_generator_frequency;
+  std::chrono::steady_clock::time_point m_start_time;
+  LoadProfile m_profile;
   size_t m_generated_events;
+  bool m_sleep;
+  bool m_thread;
+  boost::lockfree::spsc_queue<uint64_t> m_ready_queue;
+  boost::lockfree::spsc_queue<uint64_t> m_release_queue;
+  size_t generate();
 
  public:
   Controller(
     Generator const& generator,
-    MetaDataRange const& metadata_range,
-    size_t generator_frequency);
-  MetaDataRange read();
-  void release(MetaDataRange metadata_range);
+    LoadProfile const& profile,
+    bool sleep = false,
+    bool thread = false);
+  // Number of events generated since the previous read, in the order of the
+  // metadata ring
+  size_t read();
+  // The oldest events read are given back
+  void release(size_t events);
+  // Generator thread, when enabled
+  void operator()(std::shared_ptr<std::atomic<bool> > stop);
+  // Trigger schedule of the profile, the same in all the RUs: time (seconds
+  // from the start) at which the n-th event is triggered and number of events
+  // triggered before a time
+  double trigger_time(uint64_t event) const;
+  uint64_t events_before(double time) const;
 
 };
 
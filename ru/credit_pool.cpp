@@ -0,0 +1,122 @@
+#include "ru/credit_pool.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <cassert>
+#include <cmath>
+
+namespace lseb {
+
+namespace {
+
+// Weight of a new sample in the smoothed latency
+double const latency_gain = 1. / 8.;
+// Windows target this multiple of the bandwidth-delay product
+double const window_gain = 2.;
+// Rounds over which the minimum latency is taken
+int const min_latency_rounds = 8;
+
+}
+
+CreditPool::CreditPool(int destinations, int max_window, int budget)
+    :
+      m_max_window(max_window),
+      m_budget(budget),
+      m_min_window(
+        budget ? std::max(1, std::min(max_window, budget / destinations / 2))
+               : max_window),
+      m_window(
+        destinations,
+        budget ? std::max(1, std::min(max_window, budget / destinations))
+               : max_window),
+      m_latency(destinations, 0.),
+      m_min_latency(destinations),
+      m_occupancy(destinations, 0.),
+      m_samples(destinations, 0),
+      m_completed(0),
+      m_total_window(m_window.front() * destinations) {
+  assert(m_max_window > 0);
+  assert(!m_budget || m_budget >= destinations);
+}
+
+void CreditPool::completed(int destination, double latency, int pending) {
+  if (!enabled()) {
+    return;
+  }
+  double& smoothed = m_latency[destination];
+  smoothed =
+    smoothed ? smoothed + latency_gain * (latency - smoothed) : latency;
+  m_occupancy[destination] += pending;
+  ++m_samples[destination];
+  if (++m_completed == m_budget) {
+    m_completed = 0;
+    rebalance();
+  }
+}
+
+// Destinations without completions in the round keep their window
+void CreditPool::rebalance() {
+  int const destinations = m_window.size();
+  std::vector<double> excess(destinations, 0.);
+  double total_excess = 0.;
+  for (int i = 0; i < destinations; ++i) {
+    double target = m_window[i];
+    if (m_samples[i]) {
+      auto& min_latency = m_min_latency[i];
+      min_latency.push_back(m_latency[i]);
+      if (min_latency.size() > min_latency_rounds) {
+        min_latency.pop_front();
+      }
+      double const propagation = *std::min_element(
+        std::begin(min_latency),
+        std::end(min_latency));
+      double const occupancy = m_occupancy[i] / m_samples[i];
+      target = std::ceil(window_gain * occupancy * propagation / m_latency[i]);
+    }
+    excess[i] = std::max(
+      0.,
+      std::min<double>(m_max_window, target) - m_min_window);
+    total_excess += excess[i];
+    m_occupancy[i] = 0.;
+    m_samples[i] = 0;
+  }
+
+  // The spare budget goes to the destinations in proportion to their excess
+  // over the minimum window (evenly if none of them asks for more). What a
+  // destination cannot take above the credits goes to the others.
+  std::fill(std::begin(m_window), std::end(m_window), m_min_window);
+  std::vector<bool> capped(destinations, m_min_window == m_max_window);
+  int spare = m_budget - m_min_window * destinations;
+  for (bool again = true; again && spare > 0;) {
+    again = false;
+    double weight = 0.;
+    int uncapped = 0;
+    for (int i = 0; i < destinations; ++i) {
+      if (!capped[i]) {
+        weight += excess[i];
+        ++uncapped;
+      }
+    }
+    int assigned = 0;
+    for (int i = 0; i < destinations; ++i) {
+      if (capped[i]) {
+        continue;
+      }
+      double const share = weight ? excess[i] / weight : 1. / uncapped;
+      int const extra = std::min<int>(
+        m_max_window - m_window[i],
+        spare * share);
+      m_window[i] += extra;
+      assigned += extra;
+      if (m_window[i] == m_max_window) {
+        capped[i] = true;
+        again = true;
+      }
+    }
+    spare -= assigned;
+  }
+  m_total_window = std::accumulate(std::begin(m_window), std::end(m_window), 0);
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef RU_CREDIT_POOL_H
+#define RU_CREDIT_POOL_H
+
+#include <deque>
+#include <vector>
+
+namespace lseb {
+
+// Windows of multievents in flight towards each destination, drawn from a
+// budget shared by all of them. The windows start from an even share of the
+// budget and every destination keeps at least half of it, the rest goes where
+// it is needed. As in BBR, the window of a destination targets twice its
+// bandwidth-delay product: by Little's law the delivery rate is the mean
+// occupancy of the window over the smoothed completion latency, and the
+// propagation delay is the minimum of the smoothed latency over the last
+// rounds. The budget above the minimum windows is shared in proportion to the
+// targets: a destination that fills its window without queueing grows, while
+// one whose latency is inflated by queueing (a slow link) shrinks towards its
+// minimum and leaves the spare budget to the others. Windows are recomputed
+// once per budget of completions and never exceed the credits of the
+// connection (the buffers of the BU).
+class CreditPool {
+  int m_max_window;
+  int m_budget;
+  int m_min_window;
+  std::vector<int> m_window;
+  std::vector<double> m_latency;
+  std::vector<std::deque<double> > m_min_latency;
+  std::vector<double> m_occupancy;
+  std::vector<int> m_samples;
+  int m_completed;
+  int m_total_window;
+  void rebalance();
+
+ public:
+  // A null budget disables the adaptation: every window is max_window
+  CreditPool(int destinations, int max_window, int budget);
+  bool enabled() const {
+    return m_budget != 0;
+  }
+  int window(int destination) const {
+    return m_window[destination];
+  }
+  // Whether a multievent can be posted while pending ones are in flight
+  bool available(int destination, int pending) const {
+    return pending < m_window[destination];
+  }
+  // A multievent is completed after latency seconds, while pending ones
+  // (including it) were in flight
+  void completed(int destination, double latency, int pending);
+  int total_window() const {
+    return m_total_window;
+  }
+  int budget() const {
+    return m_budget;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "ru/event_filter.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "common/utility.h"
+
+namespace lseb {
+
+PrescaleFilter::PrescaleFilter(uint64_t prescale)
+    :
+      m_prescale(prescale) {
+  assert(m_prescale > 0);
+}
+
+bool PrescaleFilter::accept(
+  EventHeader const& header,
+  unsigned char const* payload,
+  size_t payload_size) {
+  return header.id % m_prescale == 0;
+}
+
+SizeCutFilter::SizeCutFilter(size_t min_size, size_t max_size)
+    :
+      m_min_size(min_size),
+      m_max_size(max_size) {
+  assert(!m_max_size || m_min_size <= m_max_size);
+}
+
+bool SizeCutFilter::accept(
+  EventHeader const& header,
+  unsigned char const* payload,
+  size_t payload_size) {
+  return payload_size >= m_min_size && (!m_max_size || payload_size <= m_max_size);
+}
+
+CallbackFilter::CallbackFilter(Callback const& callback)
+    :
+      m_callback(callback) {
+}
+
+bool CallbackFilter::accept(
+  EventHeader const& header,
+  unsigned char const* payload,
+  size_t payload_size) {
+  return m_callback(header, payload, payload_size);
+}
+
+// Nothing is moved until the first rejected event
+int compact_multievent(iovec& multievent, int events, EventFilter& filter) {
+  unsigned char* const begin = static_cast<unsigned char*>(
+    multievent.iov_base);
+  unsigned char* read = begin;
+  unsigned char* write = begin;
+  int rejected = 0;
+  for (int i = 0; i < events; ++i) {
+    assert(read < begin + multievent.iov_len);
+    EventHeader header = *pointer_cast<EventHeader>(read);
+    size_t const length = header.length;
+    assert(length >= sizeof(EventHeader));
+    if (filter.accept(
+      header,
+      read + sizeof(EventHeader),
+      length - sizeof(EventHeader))) {
+      if (write != read) {
+        std::memmove(write, read, length);
+      }
+      write += length;
+    } else {
+      header.length = sizeof(EventHeader);
+      header.flags |= rejected_event_flag;
+      std::memcpy(write, &header, sizeof(EventHeader));
+      write += sizeof(EventHeader);
+      ++rejected;
+    }
+    read += length;
+  }
+  assert(read == begin + multievent.iov_len);
+  multievent.iov_len = write - begin;
+  return rejected;
+}
+
+}
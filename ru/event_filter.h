@@ -0,0 +1,83 @@
+#ifndef RU_EVENT_FILTER_H
+#define RU_EVENT_FILTER_H
+
+#include <functional>
+#include <string>
+
+#include <cstdint>
+#include <cstdlib>
+#include <sys/uio.h>
+
+#include "common/dataformat.h"
+
+namespace lseb {
+
+// Decision of a first-level trigger on the fragment of an event, taken by the
+// RU before sending it. The BUs build events from the fragments of all the
+// sources, so decisions that depend only on the event id (as the prescale)
+// reject the same events everywhere.
+class EventFilter {
+ public:
+  virtual ~EventFilter() {
+  }
+  virtual bool accept(
+    EventHeader const& header,
+    unsigned char const* payload,
+    size_t payload_size) = 0;
+};
+
+// Accepts one event every prescale, by event id
+class PrescaleFilter : public EventFilter {
+  uint64_t m_prescale;
+
+ public:
+  PrescaleFilter(uint64_t prescale);
+  bool accept(
+    EventHeader const& header,
+    unsigned char const* payload,
+    size_t payload_size);
+};
+
+// Accepts the fragments with a payload size in [min_size, max_size], a null
+// max_size means no upper limit
+class SizeCutFilter : public EventFilter {
+  size_t m_min_size;
+  size_t m_max_size;
+
+ public:
+  SizeCutFilter(size_t min_size, size_t max_size);
+  bool accept(
+    EventHeader const& header,
+    unsigned char const* payload,
+    size_t payload_size);
+};
+
+// Delegates the decision to a user function over the payload
+class CallbackFilter : public EventFilter {
+ public:
+  using Callback = std::function<bool(
+    EventHeader const&,
+    unsigned char const*,
+    size_t)>;
+
+ private:
+  Callback m_callback;
+
+ public:
+  CallbackFilter(Callback const& callback);
+  bool accept(
+    EventHeader const& header,
+    unsigned char const* payload,
+    size_t payload_size);
+};
+
+// Compacts the rejected events out of a multievent of the given number of
+// events: their payload is dropped and the following events are moved back
+// over it, while their header is kept (flagged with rejected_event_flag) so
+// that every multievent still holds the same events for all the sources. The
+// length of the multievent is updated. Returns the number of rejected events.
+int compact_multievent(iovec& multievent, int events, EventFilter& filter);
+
+}
+
+#endif
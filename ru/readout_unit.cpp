@@ -1,10 +1,14 @@
+#include <deque>
+#include <map>
 #include <memory>
 #include <string>
 #include <thread>
 #include <chrono>
 #include <algorithm>
+#include <limits>
 
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
 
 #include "ru/readout_unit.h"
@@ -16,23 +20,122 @@
 
 namespace lseb {
 
+namespace {
+
+// Summary of the values chosen by the transports that tune their sockets
+void log_tuning(std::vector<SocketTuning> const& tunings) {
+  int count = 0;
+  double rtt = 0.;
+  double bandwidth = 0.;
+  size_t min_buffer = std::numeric_limits<size_t>::max();
+  size_t max_buffer = 0;
+  for (auto const& tuning : tunings) {
+    if (tuning.buffer_size) {
+      ++count;
+      rtt += tuning.rtt;
+      bandwidth += tuning.bandwidth;
+      min_buffer = std::min(min_buffer, tuning.buffer_size);
+      max_buffer = std::max(max_buffer, tuning.buffer_size);
+    }
+  }
+  if (count) {
+    LOG(NOTICE)
+      << "Readout Unit - Tuning of "
+      << count
+      << " sockets: "
+      << rtt / count * std::micro::den
+      << " us rtt - "
+      << bandwidth / count / std::giga::num * 8.
+      << " Gb/s per peer - "
+      << min_buffer / 1024
+      << "-"
+      << max_buffer / 1024
+      << " KiB buffers";
+  }
+}
+
+}
+
 ReadoutUnit::ReadoutUnit(
   Accumulator& accumulator,
+  Scheduler& scheduler,
+  BulkController const& bulk_controller,
+  BarrelShifter const& barrel_shifter,
+  CreditPool const& credit_pool,
+  EventFilter* filter,
+  CongestionPacer const& pacer,
+  ControlClient* feedback,
   boost::lockfree::spsc_queue<iovec>& free_local_data,
   boost::lockfree::spsc_queue<iovec>& ready_local_data,
   std::vector<Endpoint> const& endpoints,
+  RoutingTable const& routing_table,
+  TcpOptions const& tcp_options,
   int bulk_size,
+  size_t bulked_bytes,
   int credits,
+  int max_fragment_size,
+  int sender_threads,
+  int coalesce,
   int id)
     :
       m_accumulator(accumulator),
+      m_scheduler(scheduler),
+      m_bulk_controller(bulk_controller),
+      m_barrel_shifter(barrel_shifter),
+      m_credit_pool(credit_pool),
+      m_filter(filter),
+      m_pacer(pacer),
+      m_feedback(feedback),
       m_free_local_queue(free_local_data),
       m_ready_local_queue(ready_local_data),
       m_endpoints(endpoints),
+      m_routing_table(routing_table),
+      m_tcp_options(tcp_options),
+      m_connection_ids(endpoints.size()),
       m_bulk_size(bulk_size),
+      m_bulked_bytes(bulked_bytes),
       m_credits(credits),
+      m_max_fragment_size(max_fragment_size),
+      m_sender_threads(sender_threads),
+      m_coalesce(coalesce),
       m_id(id),
-      m_pending_local_iov(0) {
+      m_shard_ids(endpoints.size(), -1),
+      m_pending(endpoints.size(), 0),
+      m_in_flight(endpoints.size()),
+      m_transfer_sizes(endpoints.size()) {
+}
+
+// A transfer holds up to m_coalesce multievents, or a piece of one of them
+// with a byte budget
+size_t ReadoutUnit::chunk_size() const {
+  return m_bulked_bytes ?
+    m_bulked_bytes : m_max_fragment_size * m_bulk_size * m_coalesce;
+}
+
+void ReadoutUnit::post(int id, iovec const& iov) {
+  assert(m_credit_pool.available(id, m_pending[id]));
+  if (id != m_id) {
+    m_shards[m_shard_ids[id]]->push(id, iov);
+  } else {
+    while (!m_ready_local_queue.push(iov)) {
+      ;
+    }
+  }
+  ++m_pending[id];
+}
+
+// Transfers complete in order on each connection
+void ReadoutUnit::complete(int id, std::vector<uint64_t>& wr_to_release) {
+  --m_pending[id];
+  assert(m_pending[id] >= 0 && m_pending[id] <= m_credits);
+  auto& in_flight = m_in_flight[id];
+  int const multievents = m_transfer_sizes[id].front();
+  m_transfer_sizes[id].pop_front();
+  wr_to_release.insert(
+    std::end(wr_to_release),
+    std::begin(in_flight),
+    std::begin(in_flight) + multievents);
+  in_flight.erase(std::begin(in_flight), std::begin(in_flight) + multievents);
 }
 
 void ReadoutUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
@@ -42,20 +145,34 @@ void ReadoutUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
   LOG(NOTICE) << "Readout Unit - Waiting for connections...";
 
   DataRange const data_range = m_accumulator.data_range();
-  Connector<SendSocket> connector(m_credits);
+  size_t const data_size = std::distance(
+    std::begin(data_range),
+    std::end(data_range));
+  Handshake const handshake = { static_cast<uint32_t>(m_id),
+    static_cast<uint32_t>(m_credits), static_cast<uint64_t>(chunk_size()) };
+
+  std::map<TransportType, std::unique_ptr<Connector> > connectors;
+  for (auto type : m_routing_table.transports()) {
+    connectors.emplace(type, make_connector(type, m_credits, m_tcp_options));
+  }
 
   for (auto id : id_sequence) {
     if (id != m_id) {
       Endpoint const& ep = m_endpoints[id];
+      auto& connector = *(connectors.at(m_routing_table.route(id)));
       bool connected = false;
       while (!connected) {
         try {
-          auto ret = m_connection_ids.emplace(
-            std::make_pair(id, connector.connect(ep.hostname(), ep.port())));
-          assert(ret.second && "Connection already present");
-          ret.first->second->register_memory(
+          assert(!m_connection_ids[id] && "Connection already present");
+          m_connection_ids[id] = connector.connect(
+            ep.hostname(),
+            ep.port(),
+            handshake);
+          // Multievents wrapping around the end of the data buffer continue
+          // in its second mapping
+          m_connection_ids[id]->register_memory(
             (void*) std::begin(data_range),
-            std::distance(std::begin(data_range), std::end(data_range)));
+            2 * data_size);
           connected = true;
         } catch (std::exception& e) {
           std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -66,11 +183,43 @@ void ReadoutUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
         << ep.hostname()
         << " (bu "
         << id
+        << ", "
+        << transport_to_string(m_routing_table.route(id))
         << ")";
     }
   }
   LOG(NOTICE) << "Readout Unit - All connections established";
 
+  // Split the connections among the shards, each one driven by a sender
+  // thread (or polled by this thread if there are no sender threads)
+  int const shards = std::min<int>(
+    std::max(m_sender_threads, 1),
+    m_endpoints.size() - 1);
+  std::vector<std::vector<SendSocket*> > shard_connections(
+    shards,
+    std::vector<SendSocket*>(m_endpoints.size(), nullptr));
+  int next_shard = 0;
+  for (auto id : id_sequence) {
+    if (id != m_id) {
+      m_shard_ids[id] = next_shard;
+      shard_connections[next_shard][id] = m_connection_ids[id].get();
+      next_shard = (next_shard + 1) % shards;
+    }
+  }
+  for (auto const& connections : shard_connections) {
+    m_shards.emplace_back(new SenderShard(connections, m_credits));
+  }
+  std::vector<std::thread> sender_threads;
+  for (size_t i = 0; m_sender_threads && i < m_shards.size(); ++i) {
+    sender_threads.emplace_back(&SenderShard::operator(), m_shards[i].get(), stop);
+  }
+  LOG(NOTICE)
+    << "Readout Unit - "
+    << m_shards.size()
+    << " connection shards, "
+    << sender_threads.size()
+    << " sender threads";
+
   FrequencyMeter frequency(5.0);
   FrequencyMeter bandwith(5.0);  // this timeout is ignored (frequency is used)
 
@@ -79,56 +228,116 @@ void ReadoutUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
   std::chrono::high_resolution_clock::time_point t_start;
   double active_time = 0;
 
-  auto seq_it = std::begin(id_sequence);
-  std::vector<iovec> iov_to_send;
+  // Destinations of the multievents of the current cycle, their size (in
+  // events) and positions in the cycle of the multievents still to be sent to
+  // each destination
+  uint64_t cycle = 0;
+  bool assigned = false;
+  int bulk_size = m_bulk_size;
+  int remaining = 0;
+  std::vector<int> destinations;
+  std::vector<std::deque<int> > positions(m_endpoints.size());
+
+  // Pieces of the multievents of the cycle (a single one per multievent
+  // without a byte budget), first piece of each multievent, multievents
+  // acquired entirely and pieces already sent of the first multievent still
+  // to be sent to each destination
+  std::vector<Multievent> iov_to_send;
+  std::vector<int> first_piece;
+  size_t acquired = 0;
+  std::vector<int> sent_pieces(m_endpoints.size(), 0);
+
+  // Events seen and rejected by the filter since the last statistics
+  uint64_t filtered_events = 0;
+  uint64_t rejected_events = 0;
+
+  // Send time of the multievents in flight to the local BU (the shards keep
+  // the ones of their connections)
+  std::deque<std::chrono::high_resolution_clock::time_point> local_send_times;
 
   while (!(*stop)) {
 
     t_start = std::chrono::high_resolution_clock::now();
     bool active_flag = false;
-    bool conn_avail = false;
-    int seq_id = *seq_it;
 
-    // Check for data to acquire
-    std::pair<iovec, bool> p;
+    // Wait for the size and the assignment of the cycle
+    if (!assigned && m_bulk_controller.size(cycle, bulk_size)
+      && m_scheduler.assignment(cycle, destinations)) {
+      assigned = true;
+      m_accumulator.set_events_in_multievent(bulk_size);
+      remaining = destinations.size();
+      for (int pos = 0; pos < static_cast<int>(destinations.size()); ++pos) {
+        positions[destinations[pos]].push_back(pos);
+      }
+    }
+
+    // Check for data to acquire (up to the end of the cycle)
+    std::pair<Multievent, bool> p;
     p.second = true;
-    for (int i = iov_to_send.size(); i <= seq_id && p.second; ++i) {
+    while (assigned && acquired < destinations.size() && p.second) {
       p = m_accumulator.get_multievent();
       if (p.second) {
+        // The rejected events are compacted out before sending
+        if (m_filter) {
+          rejected_events += compact_multievent(
+            p.first.iov,
+            p.first.events,
+            *m_filter);
+          filtered_events += p.first.events;
+        }
+        if (first_piece.size() == acquired) {
+          first_piece.push_back(iov_to_send.size());
+        }
         iov_to_send.push_back(p.first);
+        if (p.first.last) {
+          ++acquired;
+        }
       }
     }
 
     // Check for completed wr (in all connections)
-    std::vector<void*> wr_to_release;
-    for (auto id : id_sequence) {
-      int count = 0;
-      if (id != m_id) {
-        auto& conn = *(m_connection_ids.at(id));
-        std::vector<iovec> completed_wr = conn.pop_completed();
-        for (auto const& wr : completed_wr) {
-          bandwith.add(wr.iov_len);
-          wr_to_release.push_back(wr.iov_base);
-        }
-        count = completed_wr.size();
-        conn_avail = (seq_id == id) ? (conn.pending() != m_credits) : conn_avail;
-      } else {
-        iovec iov;
-        while (m_free_local_queue.pop(iov)) {
-          wr_to_release.push_back(iov.iov_base);
-          ++count;
-          --m_pending_local_iov;
-          assert(m_pending_local_iov >= 0 && m_pending_local_iov <= m_credits);
+    std::vector<uint64_t> wr_to_release;
+    for (auto& shard : m_shards) {
+      ShardCompletion completion;
+      while (shard->pop(completion)) {
+        bandwith.add(completion.iov.iov_len);
+        m_credit_pool.completed(
+          completion.id,
+          completion.latency,
+          m_pending[completion.id]);
+        complete(completion.id, wr_to_release);
+        m_scheduler.completed(completion.id, completion.latency);
+        m_bulk_controller.completed(completion.latency);
+      }
+    }
+    iovec iov;
+    if (m_free_local_queue.pop(iov)) {
+      auto const now = std::chrono::high_resolution_clock::now();
+      do {
+        double const latency = std::chrono::duration<double>(
+          now - local_send_times.front()).count();
+        m_credit_pool.completed(m_id, latency, m_pending[m_id]);
+        complete(m_id, wr_to_release);
+        m_scheduler.completed(m_id, latency);
+        m_bulk_controller.completed(latency);
+        local_send_times.pop_front();
+      } while (m_free_local_queue.pop(iov));
+    }
+
+    // Congestion feedback of the BUs
+    if (m_feedback) {
+      auto const messages = m_feedback->poll(MessageType::CONGESTION);
+      if (!messages.empty()) {
+        auto const now = CongestionPacer::Clock::now();
+        for (auto const& message : messages) {
+          assert(message.values.size() == 3 * m_endpoints.size());
+          m_pacer.feedback(
+            message.source,
+            message.values[3 * m_id],
+            congestion_fill_ratio(message.values, m_id),
+            now);
         }
-        conn_avail = (seq_id == id) ? (m_pending_local_iov != m_credits) : conn_avail;
       }
-      if (!count) {
-         LOG(DEBUG)
-           << "Readout Unit - Completed "
-           << count
-           << " wrs of conn "
-           << id;
-       }
     }
 
     // Release completed wr
@@ -137,34 +346,94 @@ void ReadoutUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
       m_accumulator.release_multievents(wr_to_release);
     }
 
-    // If there are free resources for this connection and ready data, send it
-    if (conn_avail && iov_to_send.size() > seq_id) {
-      active_flag = true;
-      auto& iov = iov_to_send[seq_id];
-      if (seq_id != m_id) {
-        auto& conn = *(m_connection_ids.at(seq_id));
-        assert(m_credits - conn.pending() != 0);
-        conn.post_send(iov);
-      } else {
-        while (!m_ready_local_queue.push(iov)) {
-          ;
+    // Send the ready multievents of every destination with free resources, so
+    // that a congested destination does not hold back the others. Each
+    // destination gets its multievents in order (in the barrel shifter mode,
+    // only during its slots and up to the bytes of a slot, and when paced only
+    // while its bucket has tokens), and up to m_coalesce of them go in a
+    // single transfer when they are contiguous in memory (a multievent
+    // following one that wraps around the end of the data buffer continues it
+    // in the second mapping) and fit in the slot. With a byte budget, each
+    // piece of a multievent is a transfer.
+    for (auto id : id_sequence) {
+      auto& pos = positions[id];
+      int written = 0;
+      int events = 0;
+      while (!pos.empty()
+        && pos.front() < static_cast<int>(first_piece.size())
+        && first_piece[pos.front()] + sent_pieces[id]
+          < static_cast<int>(iov_to_send.size())
+        && m_credit_pool.available(id, m_pending[id])
+        && m_barrel_shifter.allowed(id) && m_pacer.allowed(id)) {
+        Multievent const& piece =
+          iov_to_send[first_piece[pos.front()] + sent_pieces[id]];
+        iovec iov = piece.iov;
+        m_in_flight[id].push_back(piece.sequence);
+        events += piece.events;
+        int pieces = 1;
+        if (piece.last) {
+          pos.pop_front();
+          sent_pieces[id] = 0;
+          ++written;
+        } else {
+          ++sent_pieces[id];
+        }
+        while (piece.last && pieces < m_coalesce && !pos.empty()
+          && pos.front() < static_cast<int>(acquired)) {
+          Multievent const& next = iov_to_send[first_piece[pos.front()]];
+          unsigned char* const end =
+            static_cast<unsigned char*>(iov.iov_base) + iov.iov_len;
+          if (!next.last
+            || (next.iov.iov_base != end
+              && next.iov.iov_base != end - data_size)
+            || iov.iov_len + next.iov.iov_len
+              > m_barrel_shifter.available(id)) {
+            break;
+          }
+          iov.iov_len += next.iov.iov_len;
+          m_in_flight[id].push_back(next.sequence);
+          events += next.events;
+          pos.pop_front();
+          ++pieces;
+          ++written;
+        }
+        size_t const bytes = iov.iov_len;
+        m_transfer_sizes[id].push_back(pieces);
+        m_scheduler.sent(id, m_pending[id]);
+        post(id, iov);
+        if (id == m_id) {
+          local_send_times.push_back(std::chrono::high_resolution_clock::now());
         }
-        ++m_pending_local_iov;
-        assert(
-          m_pending_local_iov >= 0 && m_pending_local_iov <= m_credits);
+        m_barrel_shifter.sent(id, bytes);
+        m_pacer.sent(id, bytes);
       }
-      LOG(DEBUG) << "Readout Unit - Written 1 wrs to conn " << seq_id;
-      frequency.add(m_bulk_size);
-
-      // Increment seq_it and check for end of a cycle
-      if (++seq_it == std::end(id_sequence)) {
-        // End of a cycle
-        seq_it = std::begin(id_sequence);
-        assert(iov_to_send.size() == m_endpoints.size());
-        iov_to_send.clear();
+      if (events) {
+        active_flag = true;
+        remaining -= written;
+        frequency.add(events);
+        LOG(DEBUG)
+          << "Readout Unit - Written "
+          << written
+          << " wrs to conn "
+          << id;
       }
     }
 
+    // Without sender threads the shards are driven by this thread
+    for (size_t i = 0; !m_sender_threads && i < m_shards.size(); ++i) {
+      m_shards[i]->poll();
+    }
+
+    // Check for the end of a cycle
+    if (assigned && !remaining) {
+      assert(acquired == destinations.size());
+      iov_to_send.clear();
+      first_piece.clear();
+      acquired = 0;
+      assigned = false;
+      ++cycle;
+    }
+
     if(active_flag){
       active_time += std::chrono::duration<double>(
         std::chrono::high_resolution_clock::now() - t_start).count();
@@ -183,11 +452,82 @@ void ReadoutUnit::operator()(std::shared_ptr<std::atomic<bool> > stop) {
         << " Gb/s - "
         << active_time / tot_time * 100.
         << " %";
+      std::vector<SocketTuning> tunings;
+      for (auto& shard : m_shards) {
+        std::vector<SocketTuning> const tuning = shard->tuning();
+        tunings.insert(std::end(tunings), std::begin(tuning), std::end(tuning));
+      }
+      log_tuning(tunings);
+      if (m_credit_pool.enabled()) {
+        int min_window = m_credits;
+        int max_window = 0;
+        for (auto id : id_sequence) {
+          min_window = std::min(min_window, m_credit_pool.window(id));
+          max_window = std::max(max_window, m_credit_pool.window(id));
+        }
+        LOG(NOTICE)
+          << "Readout Unit - Credit windows: "
+          << min_window
+          << "-"
+          << max_window
+          << " ("
+          << m_credit_pool.total_window()
+          << " of "
+          << m_credit_pool.budget()
+          << ")";
+      }
+      if (m_bulk_controller.enabled()) {
+        LOG(NOTICE)
+          << "Readout Unit - Multievents of "
+          << bulk_size
+          << " events";
+      }
+      if (m_filter) {
+        LOG(NOTICE)
+          << "Readout Unit - Filter: "
+          << (filtered_events ?
+            100. * (filtered_events - rejected_events) / filtered_events :
+            0.)
+          << " % of events accepted";
+        filtered_events = 0;
+        rejected_events = 0;
+      }
+      if (m_pacer.enabled()) {
+        int paced = 0;
+        double min_rate = 0.;
+        for (auto id : id_sequence) {
+          double const rate = m_pacer.rate(id);
+          if (rate) {
+            min_rate = paced ? std::min(min_rate, rate) : rate;
+            ++paced;
+          }
+        }
+        LOG(NOTICE)
+          << "Readout Unit - Congestion: "
+          << paced
+          << " destinations paced, down to "
+          << min_rate / std::giga::num * 8.
+          << " Gb/s";
+      }
+      if (m_barrel_shifter.enabled()) {
+        std::pair<double, double> const utilization =
+          m_barrel_shifter.utilization();
+        LOG(NOTICE)
+          << "Readout Unit - Barrel shifter: "
+          << utilization.first * 100.
+          << " % of slots used - "
+          << utilization.second * 100.
+          << " % of slot capacity";
+      }
       active_time = 0;
       t_tot = std::chrono::high_resolution_clock::now();
     }
   }
 
+  for (auto& th : sender_threads) {
+    th.join();
+  }
+
   LOG(INFO) << "Readout Unit: exiting";
 }
 
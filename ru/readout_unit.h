@@ -1,39 +1,84 @@
 #ifndef RU_READOUT_UNIT_H
 #define RU_READOUT_UNIT_H
 
-#include <map>
+#include <deque>
+#include <vector>
 #include <atomic>
+#include <memory>
 
 #include <sys/uio.h>
 
 #include <boost/lockfree/spsc_queue.hpp>
 
+#include "control/control_client.h"
+
 #include "ru/accumulator.h"
+#include "ru/scheduler.h"
+#include "ru/bulk_controller.h"
+#include "ru/barrel_shifter.h"
+#include "ru/credit_pool.h"
+#include "ru/event_filter.h"
+#include "ru/congestion_pacer.h"
+#include "ru/sender_shard.h"
 
 #include "transport/transport.h"
 #include "transport/endpoints.h"
+#include "transport/routing_table.h"
 
 namespace lseb {
 
 class ReadoutUnit {
   Accumulator& m_accumulator;
+  Scheduler& m_scheduler;
+  BulkController m_bulk_controller;
+  BarrelShifter m_barrel_shifter;
+  CreditPool m_credit_pool;
+  EventFilter* m_filter;
+  CongestionPacer m_pacer;
+  ControlClient* m_feedback;
   boost::lockfree::spsc_queue<iovec>& m_free_local_queue;
   boost::lockfree::spsc_queue<iovec>& m_ready_local_queue;
   std::vector<Endpoint> m_endpoints;
-  std::map<int, std::unique_ptr<SendSocket> > m_connection_ids;
+  RoutingTable m_routing_table;
+  TcpOptions m_tcp_options;
+  std::vector<std::unique_ptr<SendSocket> > m_connection_ids;
   int m_bulk_size;
+  size_t m_bulked_bytes;
   int m_credits;
+  int m_max_fragment_size;
+  int m_sender_threads;
+  int m_coalesce;
   int m_id;
-  int m_pending_local_iov;
+  std::vector<std::unique_ptr<SenderShard> > m_shards;
+  std::vector<int> m_shard_ids;
+  std::vector<int> m_pending;
+  std::vector<std::deque<uint64_t> > m_in_flight;
+  std::vector<std::deque<int> > m_transfer_sizes;
+  size_t chunk_size() const;
+  void post(int id, iovec const& iov);
+  void complete(int id, std::vector<uint64_t>& wr_to_release);
 
  public:
   ReadoutUnit(
     Accumulator& accumulator,
+    Scheduler& scheduler,
+    BulkController const& bulk_controller,
+    BarrelShifter const& barrel_shifter,
+    CreditPool const& credit_pool,
+    EventFilter* filter,
+    CongestionPacer const& pacer,
+    ControlClient* feedback,
     boost::lockfree::spsc_queue<iovec>& free_local_data,
     boost::lockfree::spsc_queue<iovec>& ready_local_data,
     std::vector<Endpoint> const& endpoints,
+    RoutingTable const& routing_table,
+    TcpOptions const& tcp_options,
     int bulk_size,
+    size_t bulked_bytes,
     int credits,
+    int max_fragment_size,
+    int sender_threads,
+    int coalesce,
     int id);
   void operator()(std::shared_ptr<std::atomic<bool> > stop);
 };
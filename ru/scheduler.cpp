@@ -0,0 +1,352 @@
+#include "ru/scheduler.h"
+
+#include <algorithm>
+#include <numeric>
+#include <ratio>
+#include <stdexcept>
+
+#include <cassert>
+
+#include "common/log.hpp"
+
+namespace lseb {
+
+SchedulerPolicy scheduler_policy_from_string(std::string const& str) {
+  if (str == "ROUND_ROBIN") {
+    return SchedulerPolicy::ROUND_ROBIN;
+  } else if (str == "LEAST_LOADED") {
+    return SchedulerPolicy::LEAST_LOADED;
+  } else if (str == "EVENT_MANAGER") {
+    return SchedulerPolicy::EVENT_MANAGER;
+  }
+  throw std::runtime_error("Wrong scheduler policy: " + str);
+}
+
+std::string scheduler_policy_to_string(SchedulerPolicy policy) {
+  switch (policy) {
+    case SchedulerPolicy::ROUND_ROBIN:
+      return "ROUND_ROBIN";
+    case SchedulerPolicy::LEAST_LOADED:
+      return "LEAST_LOADED";
+    case SchedulerPolicy::EVENT_MANAGER:
+      return "EVENT_MANAGER";
+  }
+  return "UNKNOWN";
+}
+
+std::vector<int> weighted_assignment(
+  std::vector<double> const& weights,
+  int length) {
+  int const nodes = weights.size();
+  assert(length >= nodes);
+  double const total = std::accumulate(
+    std::begin(weights),
+    std::end(weights),
+    0.);
+
+  // One slot each, the others proportionally to the weights (largest
+  // remainder method)
+  int const free_slots = length - nodes;
+  std::vector<int> slots(nodes, 1);
+  std::vector<std::pair<double, int> > remainders;
+  int assigned = 0;
+  for (int i = 0; i < nodes; ++i) {
+    double const share = (total > 0.) ? free_slots * weights[i] / total : 0.;
+    int const whole = static_cast<int>(share);
+    slots[i] += whole;
+    assigned += whole;
+    remainders.emplace_back(share - whole, i);
+  }
+  std::stable_sort(
+    std::begin(remainders),
+    std::end(remainders),
+    [](std::pair<double, int> const& a, std::pair<double, int> const& b) {
+      return a.first > b.first;});
+  for (int i = 0; assigned < free_slots; ++i, ++assigned) {
+    ++slots[remainders[i % nodes].second];
+  }
+
+  // Smooth weighted round-robin
+  std::vector<int> assignment;
+  std::vector<int> current(nodes, 0);
+  for (int s = 0; s < length; ++s) {
+    int best = 0;
+    for (int i = 0; i < nodes; ++i) {
+      current[i] += slots[i];
+      best = (current[i] > current[best]) ? i : best;
+    }
+    current[best] -= length;
+    assignment.push_back(best);
+  }
+  return assignment;
+}
+
+RoundRobinScheduler::RoundRobinScheduler(int nodes, int run)
+    :
+      m_nodes(nodes),
+      m_run(run) {
+  assert(m_run > 0);
+}
+
+int RoundRobinScheduler::cycle_length() {
+  return m_nodes * m_run;
+}
+
+bool RoundRobinScheduler::assignment(
+  uint64_t cycle,
+  std::vector<int>& destinations) {
+  destinations.resize(cycle_length());
+  for (size_t i = 0; i < destinations.size(); ++i) {
+    destinations[i] = i / m_run;
+  }
+  return true;
+}
+
+LeastLoadedScheduler::LeastLoadedScheduler(
+  ControlClient& control,
+  int nodes,
+  int credits,
+  SchedulerOptions const& options)
+    :
+      m_control(control),
+      m_nodes(nodes),
+      m_credits(credits),
+      m_options(options),
+      m_next_report(0),
+      m_latency(nodes, 0.),
+      m_completed(nodes, 0),
+      m_occupancy(nodes, 0.),
+      m_sent(nodes, 0) {
+  assert(m_options.slots > 0 && m_options.epoch_cycles > 0 && m_options.lag > 0);
+  // The first epochs are assigned before any load is known
+  std::vector<int> const uniform = weighted_assignment(
+    std::vector<double>(m_nodes, 1.),
+    cycle_length());
+  for (int e = 0; e < m_options.lag; ++e) {
+    m_assignments[e] = uniform;
+  }
+}
+
+int LeastLoadedScheduler::cycle_length() {
+  return m_nodes * m_options.slots;
+}
+
+// Values of a report: mean latency (ns), mean occupancy of the credits (ppm)
+// and number of completed multievents, for each destination
+void LeastLoadedScheduler::report(uint64_t epoch) {
+  std::vector<uint64_t> values;
+  for (int i = 0; i < m_nodes; ++i) {
+    values.push_back(
+      m_completed[i] ? m_latency[i] / m_completed[i] * std::nano::den : 0);
+    values.push_back(m_sent[i] ? m_occupancy[i] / m_sent[i] * std::mega::num : 0);
+    values.push_back(m_completed[i]);
+  }
+  m_control.send(MessageType::LOAD_REPORT, epoch, values);
+  std::fill(std::begin(m_latency), std::end(m_latency), 0.);
+  std::fill(std::begin(m_completed), std::end(m_completed), 0);
+  std::fill(std::begin(m_occupancy), std::end(m_occupancy), 0.);
+  std::fill(std::begin(m_sent), std::end(m_sent), 0);
+}
+
+bool LeastLoadedScheduler::assignment(
+  uint64_t cycle,
+  std::vector<int>& destinations) {
+  uint64_t const epoch = cycle / m_options.epoch_cycles;
+  if (epoch == m_next_report) {
+    report(epoch);
+    ++m_next_report;
+  }
+
+  for (auto const& message : m_control.poll(MessageType::ASSIGNMENT)) {
+    assert(message.values.size() == static_cast<size_t>(cycle_length()));
+    m_assignments[message.epoch].assign(
+      std::begin(message.values),
+      std::end(message.values));
+  }
+
+  auto it = m_assignments.find(epoch);
+  if (it == std::end(m_assignments)) {
+    return false;
+  }
+  // Assignments of the previous epochs are not needed anymore
+  m_assignments.erase(std::begin(m_assignments), it);
+  destinations = it->second;
+  return true;
+}
+
+void LeastLoadedScheduler::sent(int destination, int pending) {
+  m_occupancy[destination] += static_cast<double>(pending) / m_credits;
+  ++m_sent[destination];
+}
+
+void LeastLoadedScheduler::completed(int destination, double latency) {
+  m_latency[destination] += latency;
+  ++m_completed[destination];
+}
+
+LeastLoadedManager::LeastLoadedManager(
+  int nodes,
+  SchedulerOptions const& options)
+    :
+      m_nodes(nodes),
+      m_options(options),
+      m_weights(nodes, 1. / nodes) {
+}
+
+bool LeastLoadedManager::add(
+  ControlMessage const& report,
+  ControlMessage& assignment) {
+  assert(report.type == MessageType::LOAD_REPORT);
+  assert(report.values.size() == static_cast<size_t>(3 * m_nodes));
+  auto& reports = m_reports[report.epoch];
+  reports.push_back(report);
+  if (reports.size() != static_cast<size_t>(m_nodes)) {
+    return false;
+  }
+
+  // Load of each destination, averaged over the RUs that measured it
+  std::vector<double> load(m_nodes, 0.);
+  std::vector<int> samples(m_nodes, 0);
+  for (auto const& r : reports) {
+    for (int i = 0; i < m_nodes; ++i) {
+      double const latency = r.values[3 * i];
+      double const occupancy = r.values[3 * i + 1] / double(std::mega::num);
+      if (r.values[3 * i + 2]) {
+        load[i] += latency * (1. + occupancy);
+        ++samples[i];
+      }
+    }
+  }
+  m_reports.erase(report.epoch);
+
+  double total_load = 0.;
+  int measured = 0;
+  for (int i = 0; i < m_nodes; ++i) {
+    if (samples[i] && load[i] > 0.) {
+      load[i] /= samples[i];
+      total_load += load[i];
+      ++measured;
+    }
+  }
+
+  // Destinations without measures get the mean load; the weights are smoothed
+  // to avoid oscillations between epochs
+  if (measured) {
+    double const mean_load = total_load / measured;
+    std::vector<double> weights(m_nodes);
+    double total_weight = 0.;
+    for (int i = 0; i < m_nodes; ++i) {
+      weights[i] = 1. / ((samples[i] && load[i] > 0.) ? load[i] : mean_load);
+      total_weight += weights[i];
+    }
+    for (int i = 0; i < m_nodes; ++i) {
+      m_weights[i] = 0.5 * m_weights[i] + 0.5 * weights[i] / total_weight;
+    }
+  }
+
+  std::vector<int> const destinations = weighted_assignment(
+    m_weights,
+    m_nodes * m_options.slots);
+  assignment.type = MessageType::ASSIGNMENT;
+  assignment.source = report.source;
+  assignment.epoch = report.epoch + m_options.lag;
+  assignment.values.assign(std::begin(destinations), std::end(destinations));
+
+  LOG(DEBUG)
+    << "Least loaded manager - Assignment of epoch "
+    << assignment.epoch
+    << " computed";
+  return true;
+}
+
+PullScheduler::PullScheduler(
+  ControlClient& control,
+  int nodes,
+  SchedulerOptions const& options)
+    :
+      m_control(control),
+      m_nodes(nodes),
+      m_options(options) {
+  assert(m_options.slots > 0);
+}
+
+int PullScheduler::cycle_length() {
+  return m_nodes * m_options.slots;
+}
+
+bool PullScheduler::assignment(
+  uint64_t cycle,
+  std::vector<int>& destinations) {
+  for (auto const& message : m_control.poll(MessageType::EVENT_RANGES)) {
+    assert(message.values.size() % 2 == 0);
+    auto& assignment = m_assignments[message.epoch];
+    for (size_t i = 0; i < message.values.size(); i += 2) {
+      assignment.insert(
+        std::end(assignment),
+        message.values[i + 1],
+        message.values[i]);
+    }
+    assert(assignment.size() == static_cast<size_t>(cycle_length()));
+  }
+
+  auto it = m_assignments.find(cycle);
+  if (it == std::end(m_assignments)) {
+    return false;
+  }
+  destinations.swap(it->second);
+  m_assignments.erase(std::begin(m_assignments), ++it);
+  return true;
+}
+
+EventManager::EventManager(int nodes, SchedulerOptions const& options)
+    :
+      m_nodes(nodes),
+      m_options(options),
+      m_demand(0),
+      m_next_cycle(0) {
+}
+
+std::vector<ControlMessage> EventManager::add(ControlMessage const& request) {
+  assert(request.type == MessageType::WORK_REQUEST);
+  assert(request.values.size() == 1);
+  int const multievents = request.values.front();
+  if (multievents > 0) {
+    m_requests.emplace_back(request.source, multievents);
+    m_demand += multievents;
+  }
+
+  // A cycle is assigned only when it can be filled, so that every BU
+  // receives only the multievents it has room for
+  std::vector<ControlMessage> assignments;
+  int const length = m_nodes * m_options.slots;
+  while (m_demand >= length) {
+    ControlMessage assignment;
+    assignment.type = MessageType::EVENT_RANGES;
+    assignment.source = request.source;
+    assignment.epoch = m_next_cycle++;
+    int remaining = length;
+    while (remaining) {
+      auto& front = m_requests.front();
+      int const range = std::min(front.second, remaining);
+      assignment.values.push_back(front.first);
+      assignment.values.push_back(range);
+      remaining -= range;
+      front.second -= range;
+      if (!front.second) {
+        m_requests.pop_front();
+      }
+    }
+    m_demand -= length;
+    assignments.push_back(assignment);
+  }
+
+  LOG(DEBUG)
+    << "Event manager - "
+    << assignments.size()
+    << " cycles assigned, "
+    << m_demand
+    << " multievents requested";
+  return assignments;
+}
+
+}
@@ -0,0 +1,154 @@
+#ifndef RU_SCHEDULER_H
+#define RU_SCHEDULER_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "control/control.h"
+#include "control/control_client.h"
+
+namespace lseb {
+
+enum class SchedulerPolicy {
+  ROUND_ROBIN, LEAST_LOADED, EVENT_MANAGER
+};
+
+SchedulerPolicy scheduler_policy_from_string(std::string const& str);
+std::string scheduler_policy_to_string(SchedulerPolicy policy);
+
+struct SchedulerOptions {
+  SchedulerPolicy policy;
+  int slots;  // multievents per destination and cycle, on average
+  int epoch_cycles;  // cycles sharing the same assignment (least loaded)
+  int lag;  // epochs between a load report and the assignment based on it
+  SchedulerOptions()
+      :
+        policy(SchedulerPolicy::ROUND_ROBIN),
+        slots(2),
+        epoch_cycles(64),
+        lag(2) {
+  }
+};
+
+// Assignment of the slots of a cycle to the destinations, proportional to the
+// weights but with at least one slot each. Slots of the same destination are
+// spread over the cycle.
+std::vector<int> weighted_assignment(
+  std::vector<double> const& weights,
+  int length);
+
+// Chooses the destination of each multievent. Multievents are grouped in
+// cycles and all the RUs must get the same assignment for a cycle, since the
+// BUs build events by taking the multievents of every source in order.
+class Scheduler {
+ public:
+  virtual ~Scheduler() {
+  }
+  // Maximum number of multievents in a cycle
+  virtual int cycle_length() = 0;
+  // Destinations of the multievents of the cycle, false if not known yet
+  virtual bool assignment(uint64_t cycle, std::vector<int>& destinations) = 0;
+  // A multievent is posted while pending ones are already in flight
+  virtual void sent(int destination, int pending) {
+  }
+  // A multievent is completed after latency seconds
+  virtual void completed(int destination, double latency) {
+  }
+};
+
+// Every destination once per cycle, as in create_sequence, or for a run of
+// consecutive multievents (that can be coalesced in a single transfer)
+class RoundRobinScheduler : public Scheduler {
+  int m_nodes;
+  int m_run;
+
+ public:
+  RoundRobinScheduler(int nodes, int run = 1);
+  int cycle_length();
+  bool assignment(uint64_t cycle, std::vector<int>& destinations);
+};
+
+// Destinations get a share of the slots inversely proportional to their load,
+// measured by the RUs as completion latency and occupancy of the credits. The
+// load of each epoch is reported to the manager rank, which answers with the
+// assignment of a later epoch (see LeastLoadedManager).
+class LeastLoadedScheduler : public Scheduler {
+  ControlClient& m_control;
+  int m_nodes;
+  int m_credits;
+  SchedulerOptions m_options;
+  std::map<uint64_t, std::vector<int> > m_assignments;
+  uint64_t m_next_report;
+  std::vector<double> m_latency;
+  std::vector<int> m_completed;
+  std::vector<double> m_occupancy;
+  std::vector<int> m_sent;
+  void report(uint64_t epoch);
+
+ public:
+  LeastLoadedScheduler(
+    ControlClient& control,
+    int nodes,
+    int credits,
+    SchedulerOptions const& options);
+  int cycle_length();
+  bool assignment(uint64_t cycle, std::vector<int>& destinations);
+  void sent(int destination, int pending);
+  void completed(int destination, double latency);
+};
+
+// Runs on the manager rank. When the reports of an epoch have been received
+// from all the ranks, it computes the assignment of the epoch lag epochs later.
+class LeastLoadedManager {
+  int m_nodes;
+  SchedulerOptions m_options;
+  std::map<uint64_t, std::vector<ControlMessage> > m_reports;
+  std::vector<double> m_weights;
+
+ public:
+  LeastLoadedManager(int nodes, SchedulerOptions const& options);
+  // Returns true when an assignment is ready to be broadcast
+  bool add(ControlMessage const& report, ControlMessage& assignment);
+};
+
+// Destinations follow the ranges of multievents handed out by the event
+// manager to the BUs that requested work (see EventManager)
+class PullScheduler : public Scheduler {
+  ControlClient& m_control;
+  int m_nodes;
+  SchedulerOptions m_options;
+  std::map<uint64_t, std::vector<int> > m_assignments;
+
+ public:
+  PullScheduler(
+    ControlClient& control,
+    int nodes,
+    SchedulerOptions const& options);
+  int cycle_length();
+  bool assignment(uint64_t cycle, std::vector<int>& destinations);
+};
+
+// Runs on the manager rank. The BUs request work whenever they free memory,
+// in units of multievents, and the requests are served in order of arrival:
+// each cycle is filled with a contiguous range of multievents per request.
+// The values of an EVENT_RANGES message are (destination, multievents) pairs.
+class EventManager {
+  int m_nodes;
+  SchedulerOptions m_options;
+  std::deque<std::pair<int, int> > m_requests;
+  int m_demand;
+  uint64_t m_next_cycle;
+
+ public:
+  EventManager(int nodes, SchedulerOptions const& options);
+  // Returns the cycles that can be assigned after the request
+  std::vector<ControlMessage> add(ControlMessage const& request);
+};
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include "ru/sender_shard.h"
+
+#include <algorithm>
+
+#include <cassert>
+
+namespace lseb {
+
+namespace {
+
+// The tuning of the sockets is refreshed at most once per period (seconds)
+double const tuning_period = 1.0;
+
+int count_connections(std::vector<SendSocket*> const& connection_ids) {
+  return std::count_if(
+    std::begin(connection_ids),
+    std::end(connection_ids),
+    [](SendSocket* conn) {return conn != nullptr;});
+}
+
+}
+
+// At most credits multievents per connection are in flight, so the queues
+// never overflow. The connections that notify their completions are visited
+// only when ready, the other ones at every poll.
+SenderShard::SenderShard(
+  std::vector<SendSocket*> const& connection_ids,
+  int credits)
+    :
+      m_connection_ids(connection_ids),
+      m_ready_set(connection_ids.size()),
+      m_ready_queue(std::max(1, credits * count_connections(connection_ids))),
+      m_release_queue(std::max(1, credits * count_connections(connection_ids))),
+      m_batches(connection_ids.size()),
+      m_send_times(connection_ids.size()),
+      m_tuning_time(std::chrono::high_resolution_clock::now()) {
+  for (int id = 0; id < static_cast<int>(m_connection_ids.size()); ++id) {
+    if (m_connection_ids[id]) {
+      m_ids.push_back(id);
+      if (!m_connection_ids[id]->notify_completions(m_ready_set, id)) {
+        m_polled_ids.push_back(id);
+      }
+    }
+  }
+}
+
+void SenderShard::push(int id, iovec const& iov) {
+  assert(m_connection_ids[id] && "Connection not in the shard");
+  ShardRequest const request = { iov, id };
+  while (!m_ready_queue.push(request)) {
+    ;
+  }
+}
+
+bool SenderShard::pop(ShardCompletion& completion) {
+  return m_release_queue.pop(completion);
+}
+
+std::vector<SocketTuning> SenderShard::tuning() {
+  boost::mutex::scoped_lock lock(m_mutex);
+  return m_tuning;
+}
+
+bool SenderShard::poll() {
+  bool active = false;
+
+  // The ready multievents are posted in a batch per connection
+  ShardRequest request;
+  while (m_ready_queue.pop(request)) {
+    if (m_batches[request.id].empty()) {
+      m_batch_ids.push_back(request.id);
+    }
+    m_batches[request.id].push_back(request.iov);
+  }
+  if (!m_batch_ids.empty()) {
+    active = true;
+    auto const now = std::chrono::high_resolution_clock::now();
+    for (auto id : m_batch_ids) {
+      auto& batch = m_batches[id];
+      m_connection_ids[id]->post_send(batch);
+      m_send_times[id].insert(m_send_times[id].end(), batch.size(), now);
+      batch.clear();
+    }
+    m_batch_ids.clear();
+  }
+
+  m_ready_ids = m_polled_ids;
+  m_ready_set.take(m_ready_ids);
+  for (auto id : m_ready_ids) {
+    std::vector<iovec> completed_wr = m_connection_ids[id]->pop_completed();
+    if (completed_wr.empty()) {
+      continue;
+    }
+    active = true;
+    auto const now = std::chrono::high_resolution_clock::now();
+    auto& times = m_send_times[id];
+    for (auto const& wr : completed_wr) {
+      ShardCompletion const completion = { wr, id, std::chrono::duration<
+        double>(now - times.front()).count() };
+      times.pop_front();
+      while (!m_release_queue.push(completion)) {
+        ;
+      }
+    }
+
+    // The tuning changes only with the completions
+    if (std::chrono::duration<double>(now - m_tuning_time).count()
+      >= tuning_period) {
+      std::vector<SocketTuning> tuning;
+      for (auto tuned_id : m_ids) {
+        tuning.push_back(m_connection_ids[tuned_id]->tuning());
+      }
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_tuning.swap(tuning);
+      m_tuning_time = now;
+    }
+  }
+
+  return active;
+}
+
+void SenderShard::operator()(std::shared_ptr<std::atomic<bool> > stop) {
+  while (!(*stop)) {
+    poll();
+  }
+}
+
+}
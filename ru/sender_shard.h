@@ -0,0 +1,70 @@
+#ifndef RU_SENDER_SHARD_H
+#define RU_SENDER_SHARD_H
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+#include <sys/uio.h>
+
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/ready_set.h"
+
+#include "transport/transport.h"
+
+namespace lseb {
+
+// Multievent handed off to a shard
+struct ShardRequest {
+  iovec iov;
+  int id;
+};
+
+// Multievent completed by a shard, with its latency (seconds)
+struct ShardCompletion {
+  iovec iov;
+  int id;
+  double latency;
+};
+
+// Subset of the connections of the Readout Unit, driven by a sender thread.
+// The multievents are handed off by the Readout Unit through the ready queue
+// and given back once completed through the release queue, so that each
+// connection is used by a single thread.
+class SenderShard {
+  std::vector<SendSocket*> m_connection_ids;
+  std::vector<int> m_ids;
+  ReadySet m_ready_set;
+  std::vector<int> m_polled_ids;
+  std::vector<int> m_ready_ids;
+  boost::lockfree::spsc_queue<ShardRequest> m_ready_queue;
+  boost::lockfree::spsc_queue<ShardCompletion> m_release_queue;
+  std::vector<std::vector<iovec> > m_batches;
+  std::vector<int> m_batch_ids;
+  std::vector<std::deque<std::chrono::high_resolution_clock::time_point> > m_send_times;
+  std::chrono::high_resolution_clock::time_point m_tuning_time;
+  boost::mutex m_mutex;
+  std::vector<SocketTuning> m_tuning;
+
+ public:
+  // The connections are indexed by id (null if not in the shard)
+  SenderShard(std::vector<SendSocket*> const& connection_ids, int credits);
+
+  // Readout Unit side
+  void push(int id, iovec const& iov);
+  bool pop(ShardCompletion& completion);
+  std::vector<SocketTuning> tuning();
+
+  // Sender side: posts the ready multievents and gives back the completed
+  // ones, returns true if there was something to do
+  bool poll();
+  void operator()(std::shared_ptr<std::atomic<bool> > stop);
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include <cstdlib>
+
+#include "common/dataformat.h"
+
+using namespace lseb;
+
+// Per-event cost of the ring bookkeeping of the Generator and the Accumulator:
+// each event is written in the metadata ring, walked over by the Accumulator
+// and released, in batches. The former Buffer and range helpers wrap with a
+// modulo of the runtime size, the power-of-two ring with a mask. The bytes
+// walked over are returned and printed, so that the walk is not optimized out.
+
+namespace {
+
+uint64_t const slots = 4096;
+uint64_t const batch = 64;
+
+double buffer_events(
+  std::vector<EventMetaData>& metadata,
+  uint64_t events,
+  uint64_t& bytes) {
+  MetaDataRange range(metadata.data(), metadata.data() + metadata.size());
+  MetaDataBuffer buffer(metadata.data(), metadata.data() + metadata.size());
+  MetaDataRange::iterator current = std::begin(range);
+  bytes = 0;
+  auto const start = std::chrono::high_resolution_clock::now();
+  for (uint64_t e = 0; e < events; e += batch) {
+    for (uint64_t i = 0; i < batch && buffer.available() > 1; ++i) {
+      buffer.next_write()->offset = bytes;
+      buffer.reserve(1);
+    }
+    for (uint64_t i = 0; i < batch; ++i) {
+      bytes += current->length;
+      current = advance_in_range(current, 1, range);
+    }
+    buffer.release(buffer.ready());
+  }
+  std::chrono::duration<double, std::nano> const elapsed =
+    std::chrono::high_resolution_clock::now() - start;
+  return elapsed.count() / events;
+}
+
+double ring_events(
+  std::vector<EventMetaData>& metadata,
+  uint64_t events,
+  uint64_t& bytes) {
+  MetaDataRing buffer(metadata.data(), metadata.data() + metadata.size());
+  Ring<EventMetaData> const& ring = buffer.ring();
+  uint64_t current = 0;
+  bytes = 0;
+  auto const start = std::chrono::high_resolution_clock::now();
+  for (uint64_t e = 0; e < events; e += batch) {
+    for (uint64_t i = 0; i < batch && buffer.available(); ++i) {
+      buffer.next_write().offset = bytes;
+      buffer.reserve(1);
+    }
+    for (uint64_t i = 0; i < batch; ++i) {
+      bytes += ring[current].length;
+      ++current;
+    }
+    buffer.release(buffer.ready());
+  }
+  std::chrono::duration<double, std::nano> const elapsed =
+    std::chrono::high_resolution_clock::now() - start;
+  return elapsed.count() / events;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  uint64_t const events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+  std::vector<EventMetaData> metadata(slots, EventMetaData(0, 224, 0));
+
+  uint64_t bytes = 0;
+
+  // Warm up
+  buffer_events(metadata, events / 10, bytes);
+  ring_events(metadata, events / 10, bytes);
+
+  double const buffer_ns = buffer_events(metadata, events, bytes);
+  std::cout << "Buffer and range helpers: " << buffer_ns << " ns/event ("
+            << bytes << " bytes)" << std::endl;
+  double const ring_ns = ring_events(metadata, events, bytes);
+  std::cout << "Power-of-two ring: " << ring_ns << " ns/event (" << bytes
+            << " bytes)" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,302 @@
+#include <boost/detail/lightweight_test.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/dataformat.h"
+#include "common/log.hpp"
+#include "common/mirror_ring.h"
+#include "common/ring.h"
+#include "common/utility.h"
+
+#include "generator/generator.h"
+#include "generator/length_generator.h"
+#include "generator/load_profile.h"
+
+#include "ru/accumulator.h"
+#include "ru/controller.h"
+
+using namespace lseb;
+
+int main() {
+
+  Log::init("t_accumulator", Log::ERROR);
+
+  // Room for 4 multievents of 4 events of 224 bytes: the data ring has room
+  // for more events, the metadata ring is the limit
+  int const bulk_size = 4;
+  int const multievents = 4;
+  size_t const event_size = 224;
+  std::vector<EventMetaData> metadata(
+    bulk_size * multievents,
+    EventMetaData(0, 0, 0));
+  MirrorRing const data(
+    MirrorRing::round_size(next_power_of_two(event_size * metadata.size())));
+  MetaDataRange metadata_range(
+    metadata.data(),
+    metadata.data() + metadata.size());
+  DataRange data_range(data.begin(), data.end());
+
+  LengthGenerator length_generator(event_size - sizeof(EventHeader));
+  Generator generator(length_generator, metadata_range, data_range, 0);
+  Controller controller(generator, uniform_profile(1000000000));
+  Accumulator accumulator(
+    controller,
+    metadata_range,
+    data_range,
+    bulk_size,
+    bulk_size,
+    0,
+    0.);
+
+  // The ring is completely filled
+  std::vector<Multievent> acquired;
+  for (int i = 0; i < 10; ++i) {
+    std::pair<Multievent, bool> const p = accumulator.get_multievent();
+    if (p.second) {
+      acquired.push_back(p.first);
+    }
+  }
+  BOOST_TEST_EQ(acquired.size(), multievents);
+  for (size_t i = 0; i < acquired.size(); ++i) {
+    BOOST_TEST_EQ(acquired[i].sequence, i);
+    BOOST_TEST_EQ(acquired[i].iov.iov_len, bulk_size * event_size);
+    BOOST_TEST_EQ(
+      pointer_cast<EventHeader>(acquired[i].iov.iov_base)->id,
+      i * bulk_size);
+  }
+
+  // Memory is given back only when contiguous
+  accumulator.release_multievents( { 2 });
+  BOOST_TEST(!accumulator.get_multievent().second);
+  accumulator.release_multievents( { 0 });
+  std::pair<Multievent, bool> p = accumulator.get_multievent();
+  BOOST_TEST(p.second);
+  BOOST_TEST_EQ(p.first.sequence, 4);
+  BOOST_TEST(!accumulator.get_multievent().second);
+
+  // Releasing the gap gives back the following multievents too
+  accumulator.release_multievents( { 1 });
+  int more = 0;
+  for (int i = 0; i < 10; ++i) {
+    p = accumulator.get_multievent();
+    if (p.second) {
+      BOOST_TEST_EQ(p.first.sequence, 5 + more);
+      ++more;
+    }
+  }
+  BOOST_TEST_EQ(more, 2);
+
+  // With a data ring smaller than the metadata one, the events are generated
+  // while there is room for their data. They are written back to back, across
+  // the end of the data buffer: the multievent that wraps is contiguous
+  MirrorRing const ring(MirrorRing::page_size());
+  int const full_events = ring.size() / event_size;
+  std::vector<EventMetaData> ring_metadata(
+    next_power_of_two(full_events + 1),
+    EventMetaData(0, 0, 0));
+  MetaDataRange ring_metadata_range(
+    ring_metadata.data(),
+    ring_metadata.data() + ring_metadata.size());
+  DataRange ring_data_range(ring.begin(), ring.end());
+  Generator ring_generator(
+    length_generator,
+    ring_metadata_range,
+    ring_data_range,
+    0);
+  Controller ring_controller(ring_generator, uniform_profile(1000000000));
+  Accumulator ring_accumulator(
+    ring_controller,
+    ring_metadata_range,
+    ring_data_range,
+    full_events,
+    full_events,
+    0,
+    0.);
+  p.second = false;
+  for (int i = 0; i < 10 && !p.second; ++i) {
+    p = ring_accumulator.get_multievent();
+  }
+  BOOST_TEST(p.second);
+  BOOST_TEST(p.first.iov.iov_base == ring.begin());
+  BOOST_TEST_EQ(p.first.iov.iov_len, full_events * event_size);
+  BOOST_TEST(!ring_accumulator.get_multievent().second);
+  ring_accumulator.release_multievents( { 0 });
+  p.second = false;
+  for (int i = 0; i < 10 && !p.second; ++i) {
+    p = ring_accumulator.get_multievent();
+  }
+  BOOST_TEST(p.second);
+  unsigned char* const wrap = ring.begin() + full_events * event_size;
+  BOOST_TEST(p.first.iov.iov_base == wrap);
+  BOOST_TEST_EQ(p.first.iov.iov_len, full_events * event_size);
+  BOOST_TEST_EQ(pointer_cast<EventHeader>(wrap)->id, full_events);
+  BOOST_TEST_EQ(
+    pointer_cast<EventHeader>(wrap + event_size)->id,
+    full_events + 1);
+  BOOST_TEST_EQ(
+    pointer_cast<EventHeader>(wrap + event_size - ring.size())->id,
+    full_events + 1);
+
+  // With a byte budget of two events and a half, the multievents are cut in
+  // two pieces of two events
+  Generator budget_generator(
+    length_generator,
+    metadata_range,
+    data_range,
+    0);
+  Controller budget_controller(budget_generator, uniform_profile(1000000000));
+  Accumulator budget_accumulator(
+    budget_controller,
+    metadata_range,
+    data_range,
+    bulk_size,
+    bulk_size,
+    event_size * 5 / 2,
+    0.);
+  acquired.clear();
+  for (int i = 0; i < 20; ++i) {
+    p = budget_accumulator.get_multievent();
+    if (p.second) {
+      acquired.push_back(p.first);
+    }
+  }
+  BOOST_TEST_EQ(acquired.size(), bulk_size * multievents / 2);
+  for (size_t i = 0; i < acquired.size(); ++i) {
+    BOOST_TEST_EQ(acquired[i].sequence, i);
+    BOOST_TEST_EQ(acquired[i].events, 2);
+    BOOST_TEST_EQ(acquired[i].last, i % 2 == 1);
+    BOOST_TEST_EQ(acquired[i].iov.iov_len, 2 * event_size);
+    BOOST_TEST_EQ(
+      pointer_cast<EventHeader>(acquired[i].iov.iov_base)->id,
+      i * 2);
+  }
+
+  // Releasing the pieces of a multievent gives back its events
+  budget_accumulator.release_multievents( { 1, 0 });
+  more = 0;
+  for (int i = 0; i < 10; ++i) {
+    if (budget_accumulator.get_multievent().second) {
+      ++more;
+    }
+  }
+  BOOST_TEST_EQ(more, 2);
+
+  // After a change of size the multievents hold one event each, and the
+  // release of a larger one gives back all its events
+  Generator resize_generator(
+    length_generator,
+    metadata_range,
+    data_range,
+    0);
+  Controller resize_controller(resize_generator, uniform_profile(1000000000));
+  Accumulator resize_accumulator(
+    resize_controller,
+    metadata_range,
+    data_range,
+    bulk_size,
+    1,
+    0,
+    0.);
+  p.second = false;
+  for (int i = 0; i < 10 && !p.second; ++i) {
+    p = resize_accumulator.get_multievent();
+  }
+  BOOST_TEST(p.second);
+  BOOST_TEST_EQ(p.first.events, bulk_size);
+  resize_accumulator.set_events_in_multievent(1);
+  acquired.clear();
+  for (int i = 0; i < 40; ++i) {
+    p = resize_accumulator.get_multievent();
+    if (p.second) {
+      acquired.push_back(p.first);
+    }
+  }
+  BOOST_TEST_EQ(acquired.size(), bulk_size * (multievents - 1));
+  for (size_t i = 0; i < acquired.size(); ++i) {
+    BOOST_TEST_EQ(acquired[i].sequence, i + 1);
+    BOOST_TEST_EQ(acquired[i].events, 1);
+    BOOST_TEST(acquired[i].last);
+    BOOST_TEST_EQ(acquired[i].iov.iov_len, event_size);
+    BOOST_TEST_EQ(
+      pointer_cast<EventHeader>(acquired[i].iov.iov_base)->id,
+      bulk_size + i);
+  }
+  resize_accumulator.release_multievents( { 0 });
+  more = 0;
+  for (int i = 0; i < 10; ++i) {
+    if (resize_accumulator.get_multievent().second) {
+      ++more;
+    }
+  }
+  BOOST_TEST_EQ(more, bulk_size);
+
+  // With a maximum age of two events and a half, the multievents hold the
+  // three events triggered within it
+  Generator age_generator(length_generator, metadata_range, data_range, 0);
+  Controller age_controller(age_generator, uniform_profile(1000000000));
+  Accumulator age_accumulator(
+    age_controller,
+    metadata_range,
+    data_range,
+    bulk_size,
+    1,
+    0,
+    2.5e-9);
+  acquired.clear();
+  for (int i = 0; i < 20; ++i) {
+    p = age_accumulator.get_multievent();
+    if (p.second) {
+      acquired.push_back(p.first);
+    }
+  }
+  BOOST_TEST_EQ(acquired.size(), bulk_size * multievents / 3);
+  for (size_t i = 0; i < acquired.size(); ++i) {
+    BOOST_TEST_EQ(acquired[i].events, 3);
+    BOOST_TEST(acquired[i].last);
+    BOOST_TEST_EQ(acquired[i].iov.iov_len, 3 * event_size);
+    BOOST_TEST_EQ(
+      pointer_cast<EventHeader>(acquired[i].iov.iov_base)->id,
+      i * 3);
+  }
+
+  // With a generator thread the events keep coming as they are released
+  Generator thread_generator(length_generator, metadata_range, data_range, 0);
+  Controller thread_controller(
+    thread_generator,
+    uniform_profile(1000000000),
+    false,
+    true);
+  Accumulator thread_accumulator(
+    thread_controller,
+    metadata_range,
+    data_range,
+    bulk_size,
+    bulk_size,
+    0,
+    0.);
+  std::shared_ptr<std::atomic<bool> > stop(new std::atomic<bool>(false));
+  std::thread generator_thread(
+    &Controller::operator(),
+    &thread_controller,
+    stop);
+  uint64_t next_sequence = 0;
+  bool ordered = true;
+  while (next_sequence < 4 * multievents) {
+    p = thread_accumulator.get_multievent();
+    if (p.second) {
+      ordered = ordered && p.first.sequence == next_sequence
+        && pointer_cast<EventHeader>(p.first.iov.iov_base)->id
+          == next_sequence * bulk_size;
+      thread_accumulator.release_multievents( { p.first.sequence });
+      ++next_sequence;
+    }
+  }
+  *stop = true;
+  generator_thread.join();
+  BOOST_TEST(ordered);
+
+  return boost::report_errors();
+}
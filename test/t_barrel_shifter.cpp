@@ -0,0 +1,48 @@
+#include <chrono>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "ru/barrel_shifter.h"
+
+using namespace lseb;
+
+int main() {
+
+  int const nodes = 4;
+  int const id = 1;
+
+  // Disabled: every destination is always allowed
+  BarrelShifter disabled(id, nodes, std::chrono::nanoseconds(0), 0.);
+  BOOST_TEST(!disabled.enabled());
+  for (int i = 0; i < nodes; ++i) {
+    BOOST_TEST(disabled.allowed(i));
+  }
+
+  // Enabled: the local BU and the BU of the current slot only. A long slot
+  // keeps the test away from slot boundaries.
+  BarrelShifter shifter(id, nodes, std::chrono::seconds(3600), 1000.);
+  BOOST_TEST(shifter.enabled());
+  int const slot_destination = (id + shifter.current_slot()) % nodes;
+  for (int i = 0; i < nodes; ++i) {
+    BOOST_TEST_EQ(shifter.allowed(i), i == id || i == slot_destination);
+  }
+
+  // The slot carries up to its capacity
+  if (slot_destination != id) {
+    BOOST_TEST_EQ(shifter.available(slot_destination), 1000.);
+    shifter.sent(slot_destination, 600);
+    BOOST_TEST_EQ(shifter.available(slot_destination), 400.);
+    BOOST_TEST(shifter.allowed(slot_destination));
+    shifter.sent(slot_destination, 600);
+    BOOST_TEST_EQ(shifter.available(slot_destination), 0.);
+    BOOST_TEST(!shifter.allowed(slot_destination));
+    BOOST_TEST(shifter.allowed(id));
+  }
+
+  // Slot length from the multievent size and the link speed
+  BOOST_TEST_EQ(
+    barrel_slot_length(1000., 1e9, 0.5).count(),
+    1500);
+
+  return boost::report_errors();
+}
@@ -0,0 +1,63 @@
+#include <vector>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "ru/bulk_controller.h"
+
+using namespace lseb;
+
+namespace {
+
+// Reports of all the ranks for an epoch, with the latency (ns) of the slowest
+// one. Returns the size broadcast by the manager, 0 if none.
+int report(BulkManager& manager, int nodes, uint64_t epoch, uint64_t latency) {
+  ControlMessage size;
+  int events = 0;
+  for (int rank = 0; rank < nodes; ++rank) {
+    ControlMessage report;
+    report.type = MessageType::BULK_REPORT;
+    report.source = rank;
+    report.epoch = epoch;
+    report.values = { rank ? latency / 2 : latency, latency ? 10u : 0u };
+    bool const ready = manager.add(report, size);
+    BOOST_TEST_EQ(ready, rank == nodes - 1);
+    if (ready) {
+      BOOST_TEST(size.type == MessageType::BULK_SIZE);
+      events = size.values.front();
+    }
+  }
+  return events;
+}
+
+}
+
+int main() {
+
+  int const nodes = 3;
+  int const bulk_size = 400;
+
+  // Without a control connection the size is fixed
+  BulkOptions options;
+  options.min_events = 10;
+  options.target_latency = 1e-3;
+  BulkController fixed(nullptr, bulk_size, options);
+  BOOST_TEST(!fixed.enabled());
+  int events = 0;
+  BOOST_TEST(fixed.size(1000, events));
+  BOOST_TEST_EQ(events, bulk_size);
+
+  // The size follows the square root of the ratio between the target and the
+  // slowest latency, within the bounds, and stays without measures
+  BulkManager manager(nodes, bulk_size, options);
+  BOOST_TEST_EQ(report(manager, nodes, 0, 4000000), bulk_size / 2);
+  BOOST_TEST_EQ(report(manager, nodes, 1, 0), bulk_size / 2);
+  BOOST_TEST_EQ(report(manager, nodes, 2, 1000000000), bulk_size / 4);
+  BOOST_TEST_EQ(report(manager, nodes, 3, 250000), bulk_size / 2);
+  BOOST_TEST_EQ(report(manager, nodes, 4, 1000), bulk_size);
+  for (int epoch = 5; epoch < 20; ++epoch) {
+    report(manager, nodes, epoch, 1000000000);
+  }
+  BOOST_TEST_EQ(report(manager, nodes, 20, 1000000000), options.min_events);
+
+  return boost::report_errors();
+}
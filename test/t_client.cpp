@@ -17,6 +17,7 @@ int main(int argc, char* argv[]) {
   std::string port;
   size_t chunk_size;
   int credits;
+  std::string transport;
 
   desc.add_options()("help,h", "Print help messages.")(
     "server,s",
@@ -30,7 +31,11 @@ int main(int argc, char* argv[]) {
     "Buffer size.")(
     "credits,C",
     boost::program_options::value<int>(&credits)->required(),
-    "Credits.");
+    "Credits.")(
+    "transport,t",
+    boost::program_options::value<std::string>(&transport)->default_value(
+      DEFAULT_TRANSPORT),
+    "Transport layer (TCP, VERBS or SHM).");
 
   try {
     boost::program_options::variables_map vm;
@@ -56,8 +61,13 @@ int main(int argc, char* argv[]) {
 
   MemoryPool pool(buffer_ptr.get(), buffer_size, chunk_size);
 
-  Connector<SendSocket> connector(credits);
-  std::unique_ptr<SendSocket> socket(connector.connect(server, port));
+  std::unique_ptr<Connector> connector = make_connector(
+    transport_from_string(transport),
+    credits);
+  std::unique_ptr<SendSocket> socket(connector->connect(
+    server,
+    port,
+    { 0, static_cast<uint32_t>(credits), chunk_size }));
   socket->register_memory(buffer_ptr.get(), buffer_size);
   std::cout << "Connected to " << server << " on port " << port << std::endl;
 
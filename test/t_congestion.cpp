@@ -0,0 +1,103 @@
+#include <boost/detail/lightweight_test.hpp>
+
+#include <chrono>
+#include <vector>
+
+#include "bu/congestion_monitor.h"
+#include "ru/congestion_pacer.h"
+
+using namespace lseb;
+
+int main() {
+
+  using Clock = std::chrono::high_resolution_clock;
+  Clock::time_point const start = Clock::now();
+  auto const at = [start](int ms) {
+    return start + std::chrono::milliseconds(ms);
+  };
+
+  // Monitor: only a standing queue is marked
+  CongestionMonitor monitor(3, std::chrono::milliseconds(10), 4);
+  BOOST_TEST(monitor.enabled());
+  std::vector<uint64_t> values;
+  BOOST_TEST(!monitor.report(start, values));
+
+  monitor.posted(1, 2, at(0));
+  monitor.filled(1, 2, at(2));
+  for (int depth : { 6, 5, 7 }) {
+    monitor.queued(1, depth);
+  }
+  for (int depth : { 8, 0, 3 }) {
+    monitor.queued(2, depth);
+  }
+  BOOST_TEST(monitor.report(at(20), values));
+  BOOST_TEST_EQ(values.size(), 9);
+  BOOST_TEST_EQ(values[0], 0);
+  BOOST_TEST_EQ(values[3], 1);
+  BOOST_TEST_EQ(values[4], 5);
+  BOOST_TEST_EQ(values[5], 2000000);
+  BOOST_TEST_EQ(values[6], 0);
+  BOOST_TEST_EQ(values[7], 0);
+  BOOST_TEST(!monitor.report(at(25), values));
+
+  CongestionMonitor disabled(3, std::chrono::nanoseconds(0), 4);
+  BOOST_TEST(!disabled.enabled());
+  BOOST_TEST(!disabled.report(at(100), values));
+
+  // Pacer: a destination is paced from its measured rate once marked
+  CongestionPacer pacer(0, 3, 1000., 0.);
+  BOOST_TEST(pacer.enabled());
+  BOOST_TEST(pacer.allowed(1, at(0)));
+  pacer.sent(1, 10000);
+  pacer.feedback(1, false, 1., at(10));
+  BOOST_TEST_EQ(pacer.rate(1), 0.);
+  pacer.sent(1, 10000);
+  pacer.feedback(1, true, 1., at(20));
+  // 10000 bytes in 10 ms, about halved
+  BOOST_TEST(pacer.rate(1) > 0.5e6 && pacer.rate(1) < 0.6e6);
+
+  // The bucket empties and is refilled at the rate
+  BOOST_TEST(pacer.allowed(1, at(20)));
+  pacer.sent(1, 1500);
+  BOOST_TEST(!pacer.allowed(1, at(20)));
+  BOOST_TEST(pacer.allowed(1, at(22)));
+
+  // Further marks cut the rate, their absence lets it grow back until the
+  // destination is not paced anymore
+  double const rate = pacer.rate(1);
+  pacer.feedback(1, true, 1., at(30));
+  BOOST_TEST(pacer.rate(1) < rate);
+  for (int i = 0; i < 100 && pacer.rate(1); ++i) {
+    pacer.feedback(1, false, 1., at(40 + i * 10));
+  }
+  BOOST_TEST_EQ(pacer.rate(1), 0.);
+  BOOST_TEST(pacer.allowed(1, at(2000)));
+
+  // The local BU is never paced
+  pacer.sent(0, 10000);
+  pacer.feedback(0, true, 1., at(2010));
+  BOOST_TEST_EQ(pacer.rate(0), 0.);
+
+  // The fill time of the RU against the slowest source seeds the rate
+  std::vector<uint64_t> const fill_values = {
+    1, 8, 1000000,
+    1, 8, 4000000,
+    0, 0, 0 };
+  BOOST_TEST_EQ(congestion_fill_ratio(fill_values, 0), 0.25);
+  BOOST_TEST_EQ(congestion_fill_ratio(fill_values, 1), 1.);
+  BOOST_TEST_EQ(congestion_fill_ratio(fill_values, 2), 1.);
+  CongestionPacer seeded(0, 3, 1000., 0.);
+  seeded.feedback(1, false, 1., at(10));
+  seeded.sent(1, 10000);
+  seeded.feedback(1, true, 0.25, at(20));
+  // 10000 bytes in 10 ms, a quarter of it, about halved
+  BOOST_TEST(seeded.rate(1) > 0.12e6 && seeded.rate(1) < 0.15e6);
+
+  CongestionPacer off(0, 3, 0., 0.);
+  BOOST_TEST(!off.enabled());
+  off.sent(1, 10000);
+  off.feedback(1, true, 1., at(10));
+  BOOST_TEST_EQ(off.rate(1), 0.);
+
+  return boost::report_errors();
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "common/log.hpp"
+
+#include "control/control_client.h"
+#include "control/control_server.h"
+
+using namespace lseb;
+
+namespace {
+
+// Messages of a type received by a client within a second
+std::vector<ControlMessage> wait_for(ControlClient& client, MessageType type) {
+  std::vector<ControlMessage> messages;
+  auto const start = std::chrono::steady_clock::now();
+  while (messages.empty()
+    && std::chrono::steady_clock::now() - start < std::chrono::seconds(1)) {
+    messages = client.poll(type);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return messages;
+}
+
+}
+
+int main() {
+
+  Log::init("t_control", Log::ERROR);
+
+  int const nodes = 2;
+
+  // The manager answers each work request with the ranges of a cycle
+  std::unique_ptr<ControlServer> server;
+  server.reset(
+    new ControlServer(
+      "127.0.0.1",
+      "7780",
+      nodes,
+      [&server](ControlMessage const& message) {
+        if (message.type == MessageType::WORK_REQUEST) {
+          server->broadcast(
+            { MessageType::EVENT_RANGES, 0, message.epoch, { message.source } });
+        }
+      }));
+
+  // The first rank asks for work before the other one connects: the answer
+  // is held until all the ranks are there
+  ControlClient early("127.0.0.1", "7780", 0);
+  early.send(MessageType::WORK_REQUEST, 0, { 4 });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  BOOST_TEST(early.poll(MessageType::EVENT_RANGES).empty());
+
+  ControlClient late("127.0.0.1", "7780", 1);
+  for (ControlClient* client : { &early, &late }) {
+    std::vector<ControlMessage> const ranges = wait_for(
+      *client,
+      MessageType::EVENT_RANGES);
+    BOOST_TEST_EQ(ranges.size(), 1);
+    if (!ranges.empty()) {
+      BOOST_TEST_EQ(ranges.front().values.size(), 1);
+      BOOST_TEST_EQ(ranges.front().values.front(), 0);
+    }
+  }
+
+  // Once all the ranks are connected the messages go out at once
+  late.send(MessageType::WORK_REQUEST, 1, { 4 });
+  for (ControlClient* client : { &early, &late }) {
+    std::vector<ControlMessage> const ranges = wait_for(
+      *client,
+      MessageType::EVENT_RANGES);
+    BOOST_TEST_EQ(ranges.size(), 1);
+    if (!ranges.empty()) {
+      BOOST_TEST_EQ(ranges.front().epoch, 1);
+      BOOST_TEST_EQ(ranges.front().values.front(), 1);
+    }
+  }
+
+  return boost::report_errors();
+}
@@ -0,0 +1,101 @@
+#include <boost/detail/lightweight_test.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common/dataformat.h"
+#include "common/log.hpp"
+#include "common/mirror_ring.h"
+#include "common/utility.h"
+
+#include "generator/generator.h"
+#include "generator/length_generator.h"
+#include "generator/load_profile.h"
+
+#include "ru/controller.h"
+
+using namespace lseb;
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main() {
+
+  Log::init("t_controller", Log::ERROR);
+
+  // Room for 16 events of 224 bytes
+  size_t const slots = 16;
+  size_t const event_size = 224;
+  std::vector<EventMetaData> metadata(slots, EventMetaData(0, 0, 0));
+  MirrorRing const data(
+    MirrorRing::round_size(next_power_of_two(event_size * slots)));
+  MetaDataRange metadata_range(
+    metadata.data(),
+    metadata.data() + metadata.size());
+  DataRange data_range(data.begin(), data.end());
+  LengthGenerator length_generator(event_size - sizeof(EventHeader));
+  // Allowed delay of the wake-up from a sleep (seconds)
+  double const tolerance = 0.05;
+
+  {
+    // The events due are returned at once, as many as the Generator has
+    // room for
+    Generator generator(length_generator, metadata_range, data_range, 0);
+    Controller controller(generator, uniform_profile(1000000000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    BOOST_TEST_EQ(controller.read(), slots);
+
+    // A full Generator does not block the read
+    auto const start = std::chrono::steady_clock::now();
+    BOOST_TEST_EQ(controller.read(), 0);
+    BOOST_TEST(seconds_since(start) < 0.1);
+
+    // The released room is filled by the next read
+    controller.release(4);
+    BOOST_TEST_EQ(controller.read(), 4);
+  }
+
+  {
+    // With sleep, a read without events due waits for the next trigger: one
+    // event every 20 ms, the first one at the start
+    double const period = 0.02;
+    Generator generator(length_generator, metadata_range, data_range, 0);
+    auto const start = std::chrono::steady_clock::now();
+    Controller controller(generator, uniform_profile(1. / period), true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    BOOST_TEST_EQ(controller.read(), 1);
+    BOOST_TEST(seconds_since(start) < period);
+
+    BOOST_TEST_EQ(controller.read(), 0);
+    double const elapsed = seconds_since(start);
+    BOOST_TEST(elapsed >= period);
+    BOOST_TEST(elapsed < period + tolerance);
+
+    // The event the read waited for is due
+    BOOST_TEST(controller.read() >= 1);
+  }
+
+  {
+    // With sleep, a read on a full Generator waits one mean period: one event
+    // every 10 ms, 20 of them due when the Generator has room for 16
+    double const period = 0.01;
+    Generator generator(length_generator, metadata_range, data_range, 0);
+    Controller controller(generator, uniform_profile(1. / period), true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(195));
+    BOOST_TEST_EQ(controller.read(), slots);
+    auto const start = std::chrono::steady_clock::now();
+    BOOST_TEST_EQ(controller.read(), 0);
+    double const elapsed = seconds_since(start);
+    BOOST_TEST(elapsed >= period);
+    BOOST_TEST(elapsed < period + tolerance);
+  }
+
+  return boost::report_errors();
+}
@@ -0,0 +1,74 @@
+#include <boost/detail/lightweight_test.hpp>
+
+#include "ru/credit_pool.h"
+
+using namespace lseb;
+
+int main() {
+
+  // Without a budget the windows are fixed
+  CreditPool fixed(4, 8, 0);
+  BOOST_TEST(!fixed.enabled());
+  for (int i = 0; i < 100; ++i) {
+    fixed.completed(0, 1., 1);
+  }
+  BOOST_TEST_EQ(fixed.window(0), 8);
+  BOOST_TEST(fixed.available(0, 7));
+  BOOST_TEST(!fixed.available(0, 8));
+
+  // The budget is shared evenly at start
+  CreditPool pool(4, 8, 24);
+  BOOST_TEST(pool.enabled());
+  for (int i = 0; i < 4; ++i) {
+    BOOST_TEST_EQ(pool.window(i), 6);
+  }
+  BOOST_TEST_EQ(pool.total_window(), 24);
+
+  // Destinations that fill their window without queueing ask for more than
+  // the budget, which is shared among them
+  for (int n = 0; n < 12; ++n) {
+    for (int i = 0; i < 4; ++i) {
+      pool.completed(i, 1e-3, pool.window(i));
+    }
+  }
+  BOOST_TEST(pool.total_window() <= 24);
+  BOOST_TEST(pool.total_window() >= 20);
+
+  // A destination whose latency is inflated by queueing shrinks to its minimum
+  // window and the others get the spare budget
+  for (int n = 0; n < 18; ++n) {
+    for (int i = 0; i < 4; ++i) {
+      pool.completed(i, i == 3 ? 1e-2 : 1e-3, pool.window(i));
+    }
+  }
+  BOOST_TEST_EQ(pool.window(3), 3);
+  BOOST_TEST(pool.window(0) > 6);
+  BOOST_TEST(pool.total_window() <= 24);
+
+  // Until the higher latency lasts long enough to be taken as propagation
+  for (int n = 0; n < 60; ++n) {
+    for (int i = 0; i < 4; ++i) {
+      pool.completed(i, i == 3 ? 1e-2 : 1e-3, pool.window(i));
+    }
+  }
+  BOOST_TEST(pool.window(3) > 3);
+
+  // Windows do not exceed the credits, even if the budget is larger
+  CreditPool large(2, 4, 12);
+  for (int n = 0; n < 24; ++n) {
+    large.completed(n % 2, 1e-3, large.window(n % 2));
+  }
+  BOOST_TEST_EQ(large.window(0), 4);
+  BOOST_TEST_EQ(large.total_window(), 8);
+
+  // A destination with little traffic leaves its share to the others
+  CreditPool idle(3, 8, 12);
+  for (int n = 0; n < 12; ++n) {
+    idle.completed(0, 1e-3, 1);
+  }
+  BOOST_TEST_EQ(idle.window(0), 2);
+  BOOST_TEST_EQ(idle.window(1), 5);
+  BOOST_TEST_EQ(idle.total_window(), 12);
+
+  return boost::report_errors();
+}
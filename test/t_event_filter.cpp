@@ -0,0 +1,85 @@
+#include <boost/detail/lightweight_test.hpp>
+
+#include <vector>
+
+#include <cstring>
+
+#include "common/dataformat.h"
+#include "common/utility.h"
+
+#include "ru/event_filter.h"
+
+using namespace lseb;
+
+// Writes events with the given payload sizes, each payload filled with the
+// low byte of the event id
+iovec make_multievent(
+  std::vector<unsigned char>& buffer,
+  std::vector<size_t> const& payloads) {
+  size_t offset = 0;
+  for (size_t i = 0; i < payloads.size(); ++i) {
+    size_t const length = sizeof(EventHeader) + payloads[i];
+    new (pointer_cast<EventHeader>(&buffer[offset])) EventHeader(i, length, 2);
+    std::memset(&buffer[offset + sizeof(EventHeader)], i, payloads[i]);
+    offset += length;
+  }
+  return {buffer.data(), offset};
+}
+
+int main() {
+
+  std::vector<unsigned char> buffer(4096);
+  std::vector<size_t> const payloads = { 40, 8, 104, 72 };
+
+  // Everything accepted: nothing changes
+  PrescaleFilter all(1);
+  iovec multievent = make_multievent(buffer, payloads);
+  size_t const length = multievent.iov_len;
+  BOOST_TEST_EQ(compact_multievent(multievent, 4, all), 0);
+  BOOST_TEST_EQ(multievent.iov_len, length);
+
+  // Odd events rejected: their headers are kept without the payload and the
+  // even ones are moved back
+  PrescaleFilter even(2);
+  multievent = make_multievent(buffer, payloads);
+  BOOST_TEST_EQ(compact_multievent(multievent, 4, even), 2);
+  BOOST_TEST_EQ(
+    multievent.iov_len,
+    4 * sizeof(EventHeader) + payloads[0] + payloads[2]);
+  unsigned char* p = static_cast<unsigned char*>(multievent.iov_base);
+  for (uint64_t i = 0; i < 4; ++i) {
+    EventHeader const& header = *pointer_cast<EventHeader>(p);
+    BOOST_TEST_EQ(header.id, i);
+    BOOST_TEST_EQ(header.flags & ~rejected_event_flag, 2);
+    if (i % 2) {
+      BOOST_TEST(header.flags & rejected_event_flag);
+      BOOST_TEST_EQ(header.length, sizeof(EventHeader));
+    } else {
+      BOOST_TEST(!(header.flags & rejected_event_flag));
+      BOOST_TEST_EQ(header.length, sizeof(EventHeader) + payloads[i]);
+      BOOST_TEST_EQ(p[header.length - 1], i);
+    }
+    p += header.length;
+  }
+
+  // Size cut on the payload
+  SizeCutFilter size_cut(16, 80);
+  multievent = make_multievent(buffer, payloads);
+  BOOST_TEST_EQ(compact_multievent(multievent, 4, size_cut), 2);
+  BOOST_TEST_EQ(
+    multievent.iov_len,
+    4 * sizeof(EventHeader) + payloads[0] + payloads[3]);
+
+  // User callback over the payload
+  CallbackFilter callback(
+    [](EventHeader const& header, unsigned char const* payload, size_t size) {
+      return size && payload[0] == 3;
+    });
+  multievent = make_multievent(buffer, payloads);
+  BOOST_TEST_EQ(compact_multievent(multievent, 4, callback), 3);
+  p = static_cast<unsigned char*>(multievent.iov_base) + 3 * sizeof(EventHeader);
+  BOOST_TEST_EQ(pointer_cast<EventHeader>(p)->id, 3);
+  BOOST_TEST_EQ(p[sizeof(EventHeader)], 3);
+
+  return boost::report_errors();
+}
@@ -0,0 +1,87 @@
+#include <stdexcept>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+#include "generator/load_profile.h"
+
+using namespace lseb;
+
+int main() {
+
+  // Check uniform profile
+  LoadProfile const uniform = uniform_profile(1000.);
+  BOOST_TEST_EQ(uniform.mean_rate(), 1000.);
+  BOOST_TEST_EQ(uniform.events_before(0.), 0);
+  BOOST_TEST_EQ(uniform.events_before(0.0105), 11);
+  BOOST_TEST_EQ(uniform.events_before(2.5), 2500);
+  for (uint64_t n = 0; n < 3000; n += 7) {
+    double const time = uniform.trigger_time(n);
+    BOOST_TEST(std::abs(time - n / 1000.) < 1e-9);
+    BOOST_TEST_EQ(uniform.events_before(time + 1e-7), n + 1);
+  }
+
+  // Check filling scheme: 2 filled bunches, 3 empty, 1 filled per orbit
+  double const crossing = 40000000.;
+  LoadProfile const scheme = filling_scheme_profile("11 000 1", crossing);
+  BOOST_TEST(std::abs(scheme.mean_rate() - crossing / 2.) < 1e-3);
+  uint64_t const filled[] = { 0, 1, 5, 6, 7, 11, 12, 13, 17 };
+  for (uint64_t n = 0; n < sizeof(filled) / sizeof(filled[0]); ++n) {
+    double const time = scheme.trigger_time(n);
+    BOOST_TEST(std::abs(time * crossing - filled[n]) < 1e-6);
+    BOOST_TEST_EQ(scheme.events_before(time + 0.5 / crossing), n + 1);
+  }
+  // No events during the empty crossings
+  BOOST_TEST_EQ(scheme.events_before(2. / crossing), 2);
+  BOOST_TEST_EQ(scheme.events_before(4.5 / crossing), 2);
+
+  // The first event of each orbit follows the trailing empty crossings
+  LoadProfile const trailing = filling_scheme_profile("1101 000", 40078970.);
+  for (uint64_t orbit = 0; orbit < 100000; orbit += 997) {
+    double const time = trailing.trigger_time(orbit * 3) * 40078970.;
+    BOOST_TEST(std::abs(time - orbit * 7.) < 1e-6 * (orbit + 1));
+  }
+
+  bool thrown = false;
+  try {
+    filling_scheme_profile("10x1", crossing);
+  } catch (std::runtime_error const&) {
+    thrown = true;
+  }
+  BOOST_TEST(thrown);
+  thrown = false;
+  try {
+    filling_scheme_profile("000", crossing);
+  } catch (std::runtime_error const&) {
+    thrown = true;
+  }
+  BOOST_TEST(thrown);
+
+  // Check timeline with a gap
+  LoadProfile const timeline( { { 1., 100. }, { 1., 0. }, { 2., 50. } });
+  BOOST_TEST_EQ(timeline.mean_rate(), 50.);
+  BOOST_TEST(std::abs(timeline.trigger_time(99) - 0.99) < 1e-9);
+  BOOST_TEST(std::abs(timeline.trigger_time(100) - 2.) < 1e-9);
+  BOOST_TEST(std::abs(timeline.trigger_time(200) - 4.) < 1e-9);
+  BOOST_TEST(std::abs(timeline.trigger_time(201) - 4.01) < 1e-9);
+  BOOST_TEST_EQ(timeline.events_before(1.5), 100);
+  BOOST_TEST_EQ(timeline.events_before(3.), 150);
+
+  // Check bursts: the same seed gives the same schedule, and the trigger
+  // times increase
+  LoadProfile const bursts = burst_profile(1000., 100000., 10., 0.001, 42);
+  LoadProfile const same_bursts = burst_profile(1000., 100000., 10., 0.001, 42);
+  // Base rate plus 10 bursts/s of 100 events, on average
+  BOOST_TEST(bursts.mean_rate() > 1500. && bursts.mean_rate() < 2500.);
+  double previous = -1.;
+  for (uint64_t n = 0; n < 100000; n += 13) {
+    double const time = bursts.trigger_time(n);
+    BOOST_TEST_EQ(time, same_bursts.trigger_time(n));
+    BOOST_TEST(time > previous);
+    previous = time;
+  }
+
+  return boost::report_errors();
+}
@@ -0,0 +1,48 @@
+#include <thread>
+#include <vector>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "common/ready_set.h"
+
+using namespace lseb;
+
+int main() {
+
+  ReadySet ready_set(130);
+
+  // Nothing notified
+  std::vector<int> ids;
+  ready_set.take(ids);
+  BOOST_TEST(ids.empty());
+
+  // Ids are taken once, in increasing order, across the words
+  ready_set.notify(129);
+  ready_set.notify(3);
+  ready_set.notify(64);
+  ready_set.notify(3);
+  ready_set.take(ids);
+  BOOST_TEST(ids == std::vector<int>({ 3, 64, 129 }));
+  ids.clear();
+  ready_set.take(ids);
+  BOOST_TEST(ids.empty());
+
+  // The ids already in the vector are kept
+  ids.push_back(7);
+  ready_set.notify(0);
+  ready_set.take(ids);
+  BOOST_TEST(ids == std::vector<int>({ 7, 0 }));
+
+  // Notifications from another thread are not lost
+  std::thread th([&ready_set]() {
+    for (int i = 0; i < 130; ++i) {
+      ready_set.notify(i);
+    }
+  });
+  th.join();
+  ids.clear();
+  ready_set.take(ids);
+  BOOST_TEST_EQ(ids.size(), 130);
+
+  return boost::report_errors();
+}
@@ -0,0 +1,45 @@
+#include <vector>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "common/ring.h"
+
+using namespace lseb;
+
+int main() {
+
+  BOOST_TEST(is_power_of_two(1));
+  BOOST_TEST(is_power_of_two(4096));
+  BOOST_TEST(!is_power_of_two(0));
+  BOOST_TEST(!is_power_of_two(96));
+  BOOST_TEST_EQ(next_power_of_two(1), 1);
+  BOOST_TEST_EQ(next_power_of_two(96), 128);
+  BOOST_TEST_EQ(next_power_of_two(128), 128);
+
+  std::vector<int> buffer(8);
+  Ring<int> ring(buffer.data(), buffer.data() + buffer.size());
+  BOOST_TEST_EQ(ring.size(), 8);
+  BOOST_TEST_EQ(&ring[3], &buffer[3]);
+  BOOST_TEST_EQ(&ring[11], &buffer[3]);
+  // A difference of indices that wraps is taken back into the ring
+  BOOST_TEST_EQ(ring.offset(uint64_t(1) - 3), 6);
+
+  // Unlike Buffer, the ring can be completely filled
+  RingBuffer<int> ring_buffer(buffer.data(), buffer.data() + buffer.size());
+  BOOST_TEST_EQ(ring_buffer.available(), 8);
+  ring_buffer.reserve(8);
+  BOOST_TEST_EQ(ring_buffer.ready(), 8);
+  BOOST_TEST_EQ(ring_buffer.available(), 0);
+  BOOST_TEST_EQ(&ring_buffer.next_write(), &buffer[0]);
+
+  // The indices keep growing across the end of the buffer
+  ring_buffer.release(5);
+  ring_buffer.reserve(3);
+  BOOST_TEST_EQ(ring_buffer.read_index(), 5);
+  BOOST_TEST_EQ(ring_buffer.write_index(), 11);
+  BOOST_TEST_EQ(ring_buffer.ready(), 6);
+  BOOST_TEST_EQ(&ring_buffer.next_read(), &buffer[5]);
+  BOOST_TEST_EQ(&ring_buffer.next_write(), &buffer[3]);
+
+  return boost::report_errors();
+}
@@ -0,0 +1,41 @@
+#include <vector>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "common/ring_pool.h"
+
+using namespace lseb;
+
+int main() {
+
+  std::vector<unsigned char> buffer(100);
+  unsigned char* const begin = buffer.data();
+  RingPool pool(begin, buffer.size());
+
+  // Back to back allocations
+  iovec a = pool.alloc(40);
+  iovec b = pool.alloc(40);
+  BOOST_TEST(a.iov_base == begin);
+  BOOST_TEST(b.iov_base == begin + 40);
+  BOOST_TEST_EQ(pool.available(), 20);
+
+  // Not enough space
+  BOOST_TEST(pool.alloc(30).iov_base == nullptr);
+
+  // The tail is skipped when too short
+  pool.free(a);
+  iovec c = pool.alloc(30);
+  BOOST_TEST(c.iov_base == begin);
+  BOOST_TEST_EQ(pool.available(), 10);
+
+  // Releasing in order
+  pool.free(b);
+  pool.free(c);
+  BOOST_TEST(pool.empty());
+
+  // An empty pool restarts from the beginning
+  iovec d = pool.alloc(100);
+  BOOST_TEST(d.iov_base == begin);
+
+  return boost::report_errors();
+}
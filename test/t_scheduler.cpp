@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <vector>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "ru/scheduler.h"
+
+using namespace lseb;
+
+int main() {
+
+  int const nodes = 4;
+
+  // Round-robin assigns a multievent to each destination in turn
+  RoundRobinScheduler round_robin(nodes);
+  std::vector<int> destinations;
+  BOOST_TEST(round_robin.assignment(0, destinations));
+  BOOST_TEST(destinations == std::vector<int>({ 0, 1, 2, 3 }));
+
+  // Every destination gets at least a slot, the others follow the weights
+  std::vector<int> const weighted = weighted_assignment( { 1., 1., 6., 0. }, 12);
+  BOOST_TEST_EQ(weighted.size(), 12);
+  BOOST_TEST_EQ(std::count(std::begin(weighted), std::end(weighted), 0), 2);
+  BOOST_TEST_EQ(std::count(std::begin(weighted), std::end(weighted), 1), 2);
+  BOOST_TEST_EQ(std::count(std::begin(weighted), std::end(weighted), 2), 7);
+  BOOST_TEST_EQ(std::count(std::begin(weighted), std::end(weighted), 3), 1);
+
+  // The manager answers when all the reports of an epoch are received, giving
+  // more slots to the faster destinations
+  SchedulerOptions options;
+  options.slots = 4;
+  LeastLoadedManager manager(nodes, options);
+  ControlMessage assignment;
+  for (int rank = 0; rank < nodes; ++rank) {
+    ControlMessage report;
+    report.type = MessageType::LOAD_REPORT;
+    report.source = rank;
+    report.epoch = 3;
+    for (int i = 0; i < nodes; ++i) {
+      report.values.push_back(i == 1 ? 100000 : 10000);  // latency (ns)
+      report.values.push_back(500000);  // occupancy (ppm)
+      report.values.push_back(10);  // samples
+    }
+    BOOST_TEST_EQ(manager.add(report, assignment), rank == nodes - 1);
+  }
+  BOOST_TEST(assignment.type == MessageType::ASSIGNMENT);
+  BOOST_TEST_EQ(assignment.epoch, 3 + options.lag);
+  BOOST_TEST_EQ(assignment.values.size(), nodes * options.slots);
+  BOOST_TEST(
+    std::count(std::begin(assignment.values), std::end(assignment.values), 1)
+      < std::count(
+        std::begin(assignment.values),
+        std::end(assignment.values),
+        0));
+
+  // The event manager fills a cycle with ranges of the requests, in order of
+  // arrival, once enough multievents have been requested
+  options.slots = 1;
+  EventManager event_manager(nodes, options);
+  // (BU, multievents)
+  std::vector<std::pair<int, int> > const requests = { { 0, 3 }, { 2, 2 },
+    { 1, 3 } };
+  std::vector<ControlMessage> ranges;
+  for (auto const& r : requests) {
+    ControlMessage request;
+    request.type = MessageType::WORK_REQUEST;
+    request.source = r.first;
+    request.epoch = 0;
+    request.values.push_back(r.second);
+    std::vector<ControlMessage> const cycles = event_manager.add(request);
+    ranges.insert(std::end(ranges), std::begin(cycles), std::end(cycles));
+  }
+  BOOST_TEST_EQ(ranges.size(), 2);
+  BOOST_TEST(ranges[0].type == MessageType::EVENT_RANGES);
+  BOOST_TEST_EQ(ranges[0].epoch, 0);
+  BOOST_TEST(ranges[0].values == std::vector<uint64_t>({ 0, 3, 2, 1 }));
+  BOOST_TEST_EQ(ranges[1].epoch, 1);
+  BOOST_TEST(ranges[1].values == std::vector<uint64_t>({ 2, 1, 1, 3 }));
+
+  return boost::report_errors();
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "common/memory_pool.h"
+
+#include "transport/transport.h"
+
+#include "ru/sender_shard.h"
+
+using namespace lseb;
+
+namespace {
+
+size_t const chunk_size = 4096;
+int const credits = 4;
+int const messages = 1000;
+
+// Sends the messages through the shard, which is either polled here or
+// driven by a sender thread, and checks what is received and given back
+void run(
+  SenderShard& shard,
+  SendSocket& send_socket,
+  RecvSocket& recv_socket,
+  unsigned char* send_buffer,
+  bool polled) {
+  int const id = 1;
+  int sent = 0;
+  int released = 0;
+  int received = 0;
+  while (received != messages || released != messages) {
+    if (sent != messages && sent - released < credits) {
+      iovec const iov = {
+        send_buffer + (sent % credits) * chunk_size,
+        1 + sent % chunk_size };
+      std::fill_n(
+        static_cast<unsigned char*>(iov.iov_base),
+        iov.iov_len,
+        static_cast<unsigned char>(sent));
+      shard.push(id, iov);
+      ++sent;
+    }
+    if (polled) {
+      shard.poll();
+    }
+    ShardCompletion completion;
+    while (shard.pop(completion)) {
+      // The completions are given back in order, with their connection
+      BOOST_TEST_EQ(completion.id, id);
+      BOOST_TEST(
+        completion.iov.iov_base
+          == send_buffer + (released % credits) * chunk_size);
+      BOOST_TEST(completion.latency >= 0.);
+      ++released;
+    }
+    for (auto& iov : recv_socket.pop_completed()) {
+      BOOST_TEST_EQ(iov.iov_len, 1 + received % chunk_size);
+      unsigned char const* p = static_cast<unsigned char*>(iov.iov_base);
+      unsigned char const value = received;
+      BOOST_TEST(
+        std::all_of(p, p + iov.iov_len, [value](unsigned char c) {
+          return c == value;}));
+      ++received;
+      recv_socket.post_recv( { iov.iov_base, chunk_size });
+    }
+  }
+  BOOST_TEST_EQ(send_socket.pending(), 0);
+}
+
+}
+
+int main() {
+
+  size_t const buffer_size = chunk_size * credits;
+
+  std::vector<unsigned char> send_buffer(buffer_size);
+  std::vector<unsigned char> recv_buffer(buffer_size);
+  MemoryPool recv_pool(recv_buffer.data(), buffer_size, chunk_size);
+
+  std::unique_ptr<Acceptor> acceptor = make_acceptor(
+    TransportType::SHM,
+    credits);
+  acceptor->listen("127.0.0.1", "7778");
+  std::unique_ptr<Connector> connector = make_connector(
+    TransportType::SHM,
+    credits);
+  std::unique_ptr<SendSocket> send_socket = connector->connect(
+    "127.0.0.1",
+    "7778",
+    { 0, credits, chunk_size });
+  std::unique_ptr<RecvSocket> recv_socket = acceptor->accept();
+  send_socket->register_memory(send_buffer.data(), buffer_size);
+  recv_socket->register_memory(recv_buffer.data(), buffer_size);
+  while (!recv_pool.empty()) {
+    recv_socket->post_recv(recv_pool.alloc());
+  }
+
+  // The connection to rank 1 is in the shard, rank 0 is local
+  std::vector<SendSocket*> connection_ids = { nullptr, send_socket.get() };
+
+  // Check the handoff with the shard polled by the caller
+  {
+    SenderShard shard(connection_ids, credits);
+    run(shard, *send_socket, *recv_socket, send_buffer.data(), true);
+  }
+
+  // Check the handoff with a sender thread
+  {
+    SenderShard shard(connection_ids, credits);
+    auto stop = std::make_shared<std::atomic<bool> >(false);
+    std::thread sender(&SenderShard::operator(), &shard, stop);
+    run(shard, *send_socket, *recv_socket, send_buffer.data(), false);
+    *stop = true;
+    sender.join();
+  }
+
+  return boost::report_errors();
+}
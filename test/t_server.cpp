@@ -18,6 +18,7 @@ int main(int argc, char* argv[]) {
   std::string port;
   size_t chunk_size;
   int credits;
+  std::string transport;
 
   desc.add_options()("help,h", "Print help messages.")(
     "server,s",
@@ -31,7 +32,11 @@ int main(int argc, char* argv[]) {
     "Buffer size.")(
     "credits,C",
     boost::program_options::value<int>(&credits)->required(),
-    "Credits.");
+    "Credits.")(
+    "transport,t",
+    boost::program_options::value<std::string>(&transport)->default_value(
+      DEFAULT_TRANSPORT),
+    "Transport layer (TCP, VERBS or SHM).");
 
   try {
     boost::program_options::variables_map vm;
@@ -57,10 +62,12 @@ int main(int argc, char* argv[]) {
 
   MemoryPool pool(buffer_ptr.get(), buffer_size, chunk_size);
 
-  Acceptor<RecvSocket> acceptor(credits);
+  std::unique_ptr<Acceptor> acceptor = make_acceptor(
+    transport_from_string(transport),
+    credits);
 
-  acceptor.listen(server, port);
-  std::unique_ptr<RecvSocket> socket = acceptor.accept();
+  acceptor->listen(server, port);
+  std::unique_ptr<RecvSocket> socket = acceptor->accept();
   socket->register_memory(buffer_ptr.get(), buffer_size);
   std::cout << "Accepted connection" << std::endl;
 
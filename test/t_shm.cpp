@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "common/memory_pool.h"
+
+#include "transport/transport.h"
+
+using namespace lseb;
+
+int main() {
+
+  size_t const chunk_size = 4096;
+  int const credits = 4;
+  size_t const buffer_size = chunk_size * credits;
+
+  std::vector<unsigned char> send_buffer(buffer_size);
+  std::vector<unsigned char> recv_buffer(buffer_size);
+  MemoryPool send_pool(send_buffer.data(), buffer_size, chunk_size);
+  MemoryPool recv_pool(recv_buffer.data(), buffer_size, chunk_size);
+
+  std::unique_ptr<Acceptor> acceptor = make_acceptor(
+    TransportType::SHM,
+    credits);
+  acceptor->listen("127.0.0.1", "7777");
+  std::unique_ptr<Connector> connector = make_connector(
+    TransportType::SHM,
+    credits);
+  std::unique_ptr<SendSocket> send_socket = connector->connect(
+    "127.0.0.1",
+    "7777",
+    { 3, credits, chunk_size });
+
+  // The segment has no name left, even before the acceptor maps it
+  std::string const name = "/lseb-shm-" + std::to_string(getpid()) + "-0";
+  BOOST_TEST_EQ(shm_open(name.c_str(), O_RDWR, 0600), -1);
+
+  std::unique_ptr<RecvSocket> recv_socket = acceptor->accept();
+
+  BOOST_TEST_EQ(recv_socket->peer_hostname(), "127.0.0.1");
+  BOOST_TEST_EQ(recv_socket->peer_handshake().rank, 3);
+  BOOST_TEST_EQ(recv_socket->peer_handshake().credits, credits);
+  BOOST_TEST_EQ(recv_socket->peer_handshake().chunk_size, chunk_size);
+
+  while (!recv_pool.empty()) {
+    recv_socket->post_recv(recv_pool.alloc());
+  }
+
+  int const messages = 10000;
+  int sent = 0;
+  int received = 0;
+  while (received != messages) {
+    for (auto& iov : send_socket->pop_completed()) {
+      send_pool.free( { iov.iov_base, chunk_size });
+    }
+    if (sent != messages && send_socket->pending() != credits) {
+      iovec iov = send_pool.alloc();
+      // Variable length messages, filled with the message number
+      iov.iov_len = 1 + sent % chunk_size;
+      std::fill_n(
+        static_cast<unsigned char*>(iov.iov_base),
+        iov.iov_len,
+        static_cast<unsigned char>(sent));
+      send_socket->post_send(iov);
+      ++sent;
+    }
+    for (auto& iov : recv_socket->pop_completed()) {
+      BOOST_TEST_EQ(iov.iov_len, 1 + received % chunk_size);
+      unsigned char const* p = static_cast<unsigned char*>(iov.iov_base);
+      unsigned char const value = received;
+      BOOST_TEST(
+        std::all_of(p, p + iov.iov_len, [value](unsigned char c) {
+          return c == value;}));
+      ++received;
+      recv_socket->post_recv( { iov.iov_base, chunk_size });
+    }
+  }
+
+  return boost::report_errors();
+}
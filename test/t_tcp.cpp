@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <vector>
+
+#include <boost/detail/lightweight_test.hpp>
+
+#include "common/memory_pool.h"
+
+#include "transport/transport.h"
+
+using namespace lseb;
+
+int main() {
+
+  size_t const chunk_size = 4096;
+  int const credits = 8;
+  size_t const buffer_size = chunk_size * credits;
+
+  std::vector<unsigned char> send_buffer(buffer_size);
+  std::vector<unsigned char> recv_buffer(buffer_size);
+  MemoryPool recv_pool(recv_buffer.data(), buffer_size, chunk_size);
+
+  std::unique_ptr<Acceptor> acceptor = make_acceptor(
+    TransportType::TCP,
+    credits);
+  acceptor->listen("127.0.0.1", "7779");
+  std::unique_ptr<Connector> connector = make_connector(
+    TransportType::TCP,
+    credits);
+  std::unique_ptr<SendSocket> send_socket = connector->connect(
+    "127.0.0.1",
+    "7779",
+    { 1, credits, chunk_size });
+  std::unique_ptr<RecvSocket> recv_socket = acceptor->accept();
+
+  BOOST_TEST_EQ(recv_socket->peer_handshake().rank, 1);
+
+  while (!recv_pool.empty()) {
+    recv_socket->post_recv(recv_pool.alloc());
+  }
+
+  // Batches of a full window, posted at once: every message of a batch is
+  // pending until written and completed on its own
+  int const batches = 100;
+  int received = 0;
+  for (int b = 0; b < batches; ++b) {
+    std::vector<iovec> batch;
+    for (int i = 0; i < credits; ++i) {
+      iovec const iov = {
+        send_buffer.data() + i * chunk_size,
+        1 + (b * credits + i) % chunk_size };
+      std::fill_n(
+        static_cast<unsigned char*>(iov.iov_base),
+        iov.iov_len,
+        static_cast<unsigned char>(b * credits + i));
+      batch.push_back(iov);
+    }
+    send_socket->post_send(batch);
+    BOOST_TEST(send_socket->pending() <= credits);
+
+    int completed = 0;
+    while (completed != credits || received != (b + 1) * credits) {
+      std::vector<iovec> const completed_wr = send_socket->pop_completed();
+      for (auto const& iov : completed_wr) {
+        // Completed in order, with the length of the message
+        BOOST_TEST(iov.iov_base == batch[completed].iov_base);
+        BOOST_TEST_EQ(iov.iov_len, batch[completed].iov_len);
+        ++completed;
+      }
+      BOOST_TEST_EQ(send_socket->pending(), credits - completed);
+      for (auto& iov : recv_socket->pop_completed()) {
+        BOOST_TEST_EQ(iov.iov_len, 1 + received % chunk_size);
+        unsigned char const* p = static_cast<unsigned char*>(iov.iov_base);
+        unsigned char const value = received;
+        BOOST_TEST(
+          std::all_of(p, p + iov.iov_len, [value](unsigned char c) {
+            return c == value;}));
+        ++received;
+        recv_socket->post_recv( { iov.iov_base, chunk_size });
+      }
+    }
+  }
+  BOOST_TEST_EQ(send_socket->pending(), 0);
+
+  return boost::report_errors();
+}
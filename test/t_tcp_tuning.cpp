@@ -0,0 +1,46 @@
+#include <boost/detail/lightweight_test.hpp>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "transport/tcp/tcp_tuning.h"
+
+using namespace lseb;
+
+int main() {
+
+  size_t const min_buffer = 64 * 1024;
+  size_t const max_buffer = 4 * 1024 * 1024;
+  double const link_speed = 1.25e9;  // 10 Gb/s
+
+  // Check that an unknown product keeps the kernel autotuning
+  BOOST_TEST_EQ(tcp_buffer_size(0., 50e-6, min_buffer, max_buffer), 0);
+  BOOST_TEST_EQ(tcp_buffer_size(link_speed, 0., min_buffer, max_buffer), 0);
+
+  // Check twice the bandwidth-delay product: 10 Gb/s and 100 us
+  BOOST_TEST_EQ(
+    tcp_buffer_size(link_speed, 100e-6, min_buffer, max_buffer),
+    250000);
+
+  // Check the bounds
+  BOOST_TEST_EQ(
+    tcp_buffer_size(link_speed, 1e-6, min_buffer, max_buffer),
+    min_buffer);
+  BOOST_TEST_EQ(
+    tcp_buffer_size(link_speed, 1e-2, min_buffer, max_buffer),
+    max_buffer);
+
+  // Check that the buffers are applied, and left alone without a size
+  int const fd = socket(AF_INET, SOCK_STREAM, 0);
+  BOOST_TEST(fd >= 0);
+  size_t const default_buffer = tcp_buffer(fd, SO_SNDBUF);
+  set_tcp_buffers(fd, 0);
+  BOOST_TEST_EQ(tcp_buffer(fd, SO_SNDBUF), default_buffer);
+  set_tcp_buffers(fd, min_buffer);
+  // The kernel doubles the value for its bookkeeping
+  BOOST_TEST(tcp_buffer(fd, SO_SNDBUF) >= min_buffer);
+  BOOST_TEST(tcp_buffer(fd, SO_RCVBUF) >= min_buffer);
+  close(fd);
+
+  return boost::report_errors();
+}
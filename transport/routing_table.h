@@ -0,0 +1,64 @@
+#ifndef TRANSPORT_ROUTING_TABLE_H
+#define TRANSPORT_ROUTING_TABLE_H
+
+#include <algorithm>
+#include <vector>
+
+#include <cassert>
+
+#include "transport/transport.h"
+#include "transport/endpoints.h"
+
+namespace lseb {
+
+// Per-peer choice of the transport layer: peers sharing the hostname of the
+// local endpoint use the local transport, all the others the remote one.
+class RoutingTable {
+  std::vector<TransportType> m_routes;
+  int m_id;
+
+ public:
+  RoutingTable(
+    std::vector<Endpoint> const& endpoints,
+    int id,
+    TransportType local,
+    TransportType remote)
+      :
+        m_id(id) {
+    assert(id >= 0 && id < static_cast<int>(endpoints.size()));
+    for (auto const& ep : endpoints) {
+      m_routes.push_back(
+        (ep.hostname() == endpoints[id].hostname()) ? local : remote);
+    }
+  }
+  TransportType route(int id) const {
+    return m_routes.at(id);
+  }
+  // Number of remote peers reached through the given transport
+  int count(TransportType type) const {
+    int n = std::count(std::begin(m_routes), std::end(m_routes), type);
+    return (m_routes[m_id] == type) ? n - 1 : n;
+  }
+  // Transports used to reach at least one remote peer
+  std::vector<TransportType> transports() const {
+    std::vector<TransportType> types;
+    for (int i = 0; i < static_cast<int>(m_routes.size()); ++i) {
+      if (i != m_id && std::find(std::begin(types), std::end(types), m_routes[i])
+        == std::end(types)) {
+        types.push_back(m_routes[i]);
+      }
+    }
+    return types;
+  }
+  friend std::ostream& operator<<(std::ostream& os, RoutingTable const& table) {
+    for (size_t i = 0; i < table.m_routes.size(); ++i) {
+      os << (i ? ", " : "") << i << ":"
+         << transport_to_string(table.m_routes[i]);
+    }
+    return os;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TRANSPORT_SHM_ACCEPTOR_SHM_H
+#define TRANSPORT_SHM_ACCEPTOR_SHM_H
+
+#include <memory>
+#include <string>
+
+#include <cstdio>
+
+#include <boost/asio.hpp>
+
+#include "transport/shm/socket_shm.h"
+
+namespace lseb {
+
+class AcceptorShm : public Acceptor {
+
+  boost::asio::io_service m_io_service;
+  boost::asio::local::stream_protocol::acceptor m_acceptor;
+  std::string m_hostname;
+  std::string m_path;
+
+ public:
+  AcceptorShm(int credits)
+      :
+        m_io_service(),
+        m_acceptor(m_io_service) {
+  }
+
+  ~AcceptorShm() {
+    if (!m_path.empty()) {
+      std::remove(m_path.c_str());
+    }
+  }
+
+  void listen(std::string const& hostname, std::string const& port) {
+    m_hostname = hostname;
+    m_path = shm_rendezvous_path(hostname, port);
+    std::remove(m_path.c_str());
+    boost::asio::local::stream_protocol::endpoint endpoint(m_path);
+    m_acceptor.open(endpoint.protocol());
+    m_acceptor.bind(endpoint);
+    m_acceptor.listen();
+  }
+
+  std::unique_ptr<RecvSocket> accept() {
+    boost::asio::local::stream_protocol::socket socket(m_io_service);
+    m_acceptor.accept(socket);
+    ShmHello hello;
+    int const fd = recv_with_fd(socket.native_handle(), &hello, sizeof(hello));
+    std::unique_ptr<ShmSegment> segment(new ShmSegment(fd, hello.size));
+    std::unique_ptr<RecvSocket> recv_socket(
+      new RecvSocketShm(std::move(segment), m_hostname, hello.handshake));
+    return recv_socket;
+  }
+
+};
+
+}
+
+#endif
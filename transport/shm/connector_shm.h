@@ -0,0 +1,48 @@
+#ifndef TRANSPORT_SHM_CONNECTOR_SHM_H
+#define TRANSPORT_SHM_CONNECTOR_SHM_H
+
+#include <memory>
+#include <string>
+
+#include <cstring>
+
+#include <boost/asio.hpp>
+
+#include "transport/shm/socket_shm.h"
+
+namespace lseb {
+
+class ConnectorShm : public Connector {
+
+  boost::asio::io_service m_io_service;
+
+ public:
+  ConnectorShm(int credits)
+      :
+        m_io_service() {
+  }
+
+  std::unique_ptr<SendSocket> connect(
+    std::string const& hostname,
+    std::string const& port,
+    Handshake const& handshake) {
+    boost::asio::local::stream_protocol::socket socket(m_io_service);
+    // Throws if the acceptor is not listening yet
+    socket.connect(
+      boost::asio::local::stream_protocol::endpoint(
+        shm_rendezvous_path(hostname, port)));
+    std::unique_ptr<ShmSegment> segment(new ShmSegment(shm_ring_size));
+    ShmHello hello;
+    memset(&hello, 0, sizeof(hello));
+    hello.size = shm_ring_size;
+    hello.handshake = handshake;
+    send_with_fd(socket.native_handle(), &hello, sizeof(hello), segment->fd());
+    std::unique_ptr<SendSocket> send_socket(
+      new SendSocketShm(std::move(segment)));
+    return send_socket;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,311 @@
+#include "transport/shm/socket_shm.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lseb {
+
+namespace {
+
+// Copy up to len bytes into the ring, returns the number of bytes written
+size_t ring_push(
+  ShmRing* ring,
+  unsigned char* data,
+  unsigned char const* src,
+  size_t len) {
+  uint64_t const w = ring->write.load(std::memory_order_relaxed);
+  uint64_t const r = ring->read.load(std::memory_order_acquire);
+  size_t const n = std::min<size_t>(len, ring->size - (w - r));
+  size_t const offset = w % ring->size;
+  size_t const first = std::min<size_t>(n, ring->size - offset);
+  std::memcpy(data + offset, src, first);
+  std::memcpy(data, src + first, n - first);
+  ring->write.store(w + n, std::memory_order_release);
+  return n;
+}
+
+// Copy up to len bytes out of the ring, returns the number of bytes read
+size_t ring_pop(
+  ShmRing* ring,
+  unsigned char const* data,
+  unsigned char* dst,
+  size_t len) {
+  uint64_t const r = ring->read.load(std::memory_order_relaxed);
+  uint64_t const w = ring->write.load(std::memory_order_acquire);
+  size_t const n = std::min<size_t>(len, w - r);
+  size_t const offset = r % ring->size;
+  size_t const first = std::min<size_t>(n, ring->size - offset);
+  std::memcpy(dst, data + offset, first);
+  std::memcpy(dst + first, data, n - first);
+  ring->read.store(r + n, std::memory_order_release);
+  return n;
+}
+
+}
+
+ShmSegment::ShmSegment(size_t length)
+    :
+      m_fd(-1),
+      m_addr(nullptr),
+      m_length(sizeof(ShmRing) + length) {
+  static std::atomic<int> counter(0);
+  std::string const name = "/lseb-shm-" + std::to_string(getpid()) + "-"
+    + std::to_string(counter++);
+  m_fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (m_fd == -1) {
+    throw std::runtime_error(
+      "Error on shm_open: " + std::string(strerror(errno)));
+  }
+  shm_unlink(name.c_str());
+  if (ftruncate(m_fd, m_length)) {
+    int const error = errno;
+    close(m_fd);
+    throw std::runtime_error(
+      "Error on ftruncate: " + std::string(strerror(error)));
+  }
+  map();
+  new (m_addr) ShmRing(length);
+}
+
+ShmSegment::ShmSegment(int fd, size_t length)
+    :
+      m_fd(fd),
+      m_addr(nullptr),
+      m_length(sizeof(ShmRing) + length) {
+  struct stat st;
+  if (fstat(m_fd, &st) || static_cast<size_t>(st.st_size) < m_length) {
+    close(m_fd);
+    throw std::runtime_error("Wrong shared memory segment");
+  }
+  map();
+}
+
+void ShmSegment::map() {
+  m_addr = mmap(NULL, m_length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (m_addr == MAP_FAILED) {
+    int const error = errno;
+    close(m_fd);
+    throw std::runtime_error("Error on mmap: " + std::string(strerror(error)));
+  }
+}
+
+ShmSegment::~ShmSegment() {
+  munmap(m_addr, m_length);
+  close(m_fd);
+}
+
+void send_with_fd(int socket, void const* data, size_t length, int fd) {
+  iovec iov = { const_cast<void*>(data), length };
+  char control[CMSG_SPACE(sizeof(int))];
+  memset(control, 0, sizeof(control));
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  ssize_t const ret = sendmsg(socket, &msg, 0);
+  if (ret != static_cast<ssize_t>(length)) {
+    throw std::runtime_error(
+      "Error on sendmsg: "
+        + std::string(ret == -1 ? strerror(errno) : "short write"));
+  }
+}
+
+int recv_with_fd(int socket, void* data, size_t length) {
+  iovec iov = { data, length };
+  char control[CMSG_SPACE(sizeof(int))];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t const ret = recvmsg(socket, &msg, MSG_WAITALL);
+  if (ret == -1) {
+    throw std::runtime_error(
+      "Error on recvmsg: " + std::string(strerror(errno)));
+  }
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS) {
+    throw std::runtime_error("Error on recvmsg: no file descriptor");
+  }
+  int fd;
+  memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+  if (ret != static_cast<ssize_t>(length)) {
+    close(fd);
+    throw std::runtime_error("Error on recvmsg: short read");
+  }
+  return fd;
+}
+
+std::string shm_rendezvous_path(
+  std::string const& hostname,
+  std::string const& port) {
+  return "/tmp/lseb-shm-" + hostname + "-" + port;
+}
+
+SendSocketShm::SendSocketShm(std::unique_ptr<ShmSegment> segment)
+    :
+      m_segment(std::move(segment)),
+      m_ring(m_segment->ring()),
+      m_data(m_segment->data()),
+      m_sent_bytes(0),
+      m_header(0),
+      m_pending(0) {
+}
+
+void SendSocketShm::progress() {
+  while (!m_send_queue.empty()) {
+    iovec const& iov = m_send_queue.front();
+    if (m_sent_bytes < sizeof(m_header)) {
+      m_header = iov.iov_len;
+      m_sent_bytes += ring_push(
+        m_ring,
+        m_data,
+        reinterpret_cast<unsigned char*>(&m_header) + m_sent_bytes,
+        sizeof(m_header) - m_sent_bytes);
+      if (m_sent_bytes < sizeof(m_header)) {
+        return;
+      }
+    }
+    size_t const payload_bytes = m_sent_bytes - sizeof(m_header);
+    m_sent_bytes += ring_push(
+      m_ring,
+      m_data,
+      static_cast<unsigned char*>(iov.iov_base) + payload_bytes,
+      iov.iov_len - payload_bytes);
+    if (m_sent_bytes != sizeof(m_header) + iov.iov_len) {
+      return;
+    }
+    m_completed.push_back(iov);
+    m_send_queue.pop_front();
+    m_sent_bytes = 0;
+  }
+}
+
+std::vector<iovec> SendSocketShm::pop_completed() {
+  progress();
+  std::vector<iovec> vect;
+  vect.swap(m_completed);
+  m_pending -= vect.size();
+  return vect;
+}
+
+void SendSocketShm::post_send(iovec const& iov) {
+  ++m_pending;
+  m_send_queue.push_back(iov);
+  progress();
+}
+
+void SendSocketShm::post_send(std::vector<iovec> const& iov_vect) {
+  m_pending += iov_vect.size();
+  m_send_queue.insert(
+    std::end(m_send_queue),
+    std::begin(iov_vect),
+    std::end(iov_vect));
+  progress();
+}
+
+int SendSocketShm::pending() {
+  return m_pending;
+}
+
+RecvSocketShm::RecvSocketShm(
+  std::unique_ptr<ShmSegment> segment,
+  std::string const& peer_hostname,
+  Handshake const& peer_handshake)
+    :
+      m_segment(std::move(segment)),
+      m_ring(m_segment->ring()),
+      m_data(m_segment->data()),
+      m_peer_hostname(peer_hostname),
+      m_peer_handshake(peer_handshake),
+      m_received_bytes(0),
+      m_header(0),
+      m_ring_mode(false) {
+}
+
+std::vector<iovec> RecvSocketShm::pop_completed() {
+  std::vector<iovec> iov_vect;
+  while (m_ring_mode || !m_recv_queue.empty()) {
+    if (m_received_bytes < sizeof(m_header)) {
+      m_received_bytes += ring_pop(
+        m_ring,
+        m_data,
+        reinterpret_cast<unsigned char*>(&m_header) + m_received_bytes,
+        sizeof(m_header) - m_received_bytes);
+      if (m_received_bytes < sizeof(m_header)) {
+        break;
+      }
+    }
+    if (m_ring_mode && m_recv_queue.empty()) {
+      // Place the message in the receive ring, if there is enough space
+      iovec iov = m_ring_pool.alloc(m_header);
+      if (!iov.iov_base) {
+        break;
+      }
+      m_recv_queue.push_back(iov);
+    }
+    assert(m_header > 0 && m_header <= m_recv_queue.front().iov_len);
+    iovec const& iov = m_recv_queue.front();
+    size_t const payload_bytes = m_received_bytes - sizeof(m_header);
+    m_received_bytes += ring_pop(
+      m_ring,
+      m_data,
+      static_cast<unsigned char*>(iov.iov_base) + payload_bytes,
+      m_header - payload_bytes);
+    if (m_received_bytes != sizeof(m_header) + m_header) {
+      break;
+    }
+    iov_vect.push_back( { iov.iov_base, m_header });
+    m_recv_queue.pop_front();
+    m_received_bytes = 0;
+  }
+  return iov_vect;
+}
+
+void RecvSocketShm::post_recv(iovec const& iov) {
+  if (m_ring_mode) {
+    m_ring_pool.free(iov);
+  } else {
+    m_recv_queue.push_back(iov);
+  }
+}
+
+void RecvSocketShm::post_recv_ring(void* buffer, size_t size) {
+  assert(m_recv_queue.empty() && !m_ring_mode);
+  m_ring_mode = true;
+  m_ring_pool = RingPool(static_cast<unsigned char*>(buffer), size);
+}
+
+void RecvSocketShm::post_recv(std::vector<iovec> const& iov_vect) {
+  for (auto const& iov : iov_vect) {
+    post_recv(iov);
+  }
+}
+
+std::string RecvSocketShm::peer_hostname() {
+  return m_peer_hostname;
+}
+
+Handshake RecvSocketShm::peer_handshake() {
+  return m_peer_handshake;
+}
+
+}
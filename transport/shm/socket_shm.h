@@ -0,0 +1,133 @@
+#ifndef TRANSPORT_SHM_SOCKET_SHM_H
+#define TRANSPORT_SHM_SOCKET_SHM_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "common/ring_pool.h"
+
+#include "transport/transport.h"
+
+namespace lseb {
+
+// Size of the byte ring shared by the two ends of a connection
+static size_t const shm_ring_size = 4 * 1024 * 1024;
+
+// Header placed at the beginning of each shared segment. The two counters
+// are monotonic byte counts and live on different cache lines.
+struct ShmRing {
+  alignas(64) std::atomic<uint64_t> write;
+  alignas(64) std::atomic<uint64_t> read;
+  alignas(64) uint64_t size;
+  ShmRing(uint64_t size)
+      :
+        write(0),
+        read(0),
+        size(size) {
+  }
+};
+
+// Message sent on the rendezvous socket by the connector, along with the file
+// descriptor of the segment
+struct ShmHello {
+  uint64_t size;
+  Handshake handshake;
+};
+
+// Memory shared by the two ends of a connection. The segment is unlinked as
+// soon as it is created, so that it goes away with its last mapping whatever
+// happens to the connection, and the peer maps it through the file
+// descriptor passed on the rendezvous socket.
+class ShmSegment {
+  int m_fd;
+  void* m_addr;
+  size_t m_length;
+
+  void map();
+
+ public:
+  // Creates the segment of a ring of length bytes
+  explicit ShmSegment(size_t length);
+  // Maps the segment of a peer, taking ownership of fd
+  ShmSegment(int fd, size_t length);
+  ~ShmSegment();
+  int fd() const {
+    return m_fd;
+  }
+  ShmRing* ring() {
+    return static_cast<ShmRing*>(m_addr);
+  }
+  unsigned char* data() {
+    return static_cast<unsigned char*>(m_addr) + sizeof(ShmRing);
+  }
+
+  ShmSegment(const ShmSegment&) = delete;            // disable copying
+  ShmSegment& operator=(const ShmSegment&) = delete;  // disable assignment
+};
+
+// Sends a message and a file descriptor on a local socket
+void send_with_fd(int socket, void const* data, size_t length, int fd);
+
+// Receives a message sent by send_with_fd and returns the file descriptor
+int recv_with_fd(int socket, void* data, size_t length);
+
+std::string shm_rendezvous_path(
+  std::string const& hostname,
+  std::string const& port);
+
+class SendSocketShm : public SendSocket {
+  std::unique_ptr<ShmSegment> m_segment;
+  ShmRing* m_ring;
+  unsigned char* m_data;
+  std::deque<iovec> m_send_queue;
+  std::vector<iovec> m_completed;
+  size_t m_sent_bytes;
+  uint64_t m_header;
+  int m_pending;
+  void progress();
+
+ public:
+  SendSocketShm(std::unique_ptr<ShmSegment> segment);
+  void register_memory(void* buffer, size_t size) {
+  }
+  std::vector<iovec> pop_completed();
+  void post_send(iovec const& iov);
+  void post_send(std::vector<iovec> const& iov_vect);
+  int pending();
+};
+
+class RecvSocketShm : public RecvSocket {
+  std::unique_ptr<ShmSegment> m_segment;
+  ShmRing* m_ring;
+  unsigned char* m_data;
+  std::string m_peer_hostname;
+  Handshake m_peer_handshake;
+  std::deque<iovec> m_recv_queue;
+  size_t m_received_bytes;
+  uint64_t m_header;
+  bool m_ring_mode;
+  RingPool m_ring_pool;
+
+ public:
+  RecvSocketShm(
+    std::unique_ptr<ShmSegment> segment,
+    std::string const& peer_hostname,
+    Handshake const& peer_handshake);
+  void register_memory(void* buffer, size_t size) {
+  }
+  std::vector<iovec> pop_completed();
+  void post_recv(iovec const& iov);
+  void post_recv(std::vector<iovec> const& iov_vect);
+  void post_recv_ring(void* buffer, size_t size);
+  std::string peer_hostname();
+  Handshake peer_handshake();
+};
+
+}
+
+#endif
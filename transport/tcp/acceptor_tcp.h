@@ -15,20 +15,24 @@
 
 namespace lseb {
 
-template<typename T>
-class Acceptor {
+class AcceptorTcp : public Acceptor {
 
   boost::asio::io_service m_io_service;
   boost::asio::ip::tcp::acceptor m_acceptor;
   boost::asio::deadline_timer m_timer;
   std::vector<std::thread> m_threads;
+  TcpOptions m_options;
 
  public:
-  Acceptor(int credits, int threads = 1)
+  AcceptorTcp(
+    int credits,
+    TcpOptions const& options = TcpOptions(),
+    int threads = 1)
       :
         m_io_service(),
         m_acceptor(m_io_service),
-        m_timer(m_io_service) {
+        m_timer(m_io_service),
+        m_options(options) {
     m_timer.expires_at(boost::posix_time::pos_infin);
     m_timer.async_wait(
       [this](const boost::system::error_code &ec) {std::cout << "TIMER EXPIRED!\n";});
@@ -37,7 +41,7 @@ class Acceptor {
     }
   }
 
-  ~Acceptor() {
+  ~AcceptorTcp() {
     m_timer.cancel();
     m_io_service.stop();
     for(auto& t : m_threads) {
@@ -51,15 +55,23 @@ class Acceptor {
       std::stol(port));
     m_acceptor.open(endpoint.protocol());
     m_acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+    // Inherited by the accepted sockets
+    set_tcp_buffers(m_acceptor.native_handle(), m_options.buffer_size);
     m_acceptor.bind(endpoint);
     m_acceptor.listen();
   }
 
-  std::unique_ptr<T> accept() {
+  std::unique_ptr<RecvSocket> accept() {
     std::unique_ptr<boost::asio::ip::tcp::socket> socket_ptr(
       new boost::asio::ip::tcp::socket(m_io_service));
     m_acceptor.accept(*socket_ptr);
-    std::unique_ptr<T> socket(new T(std::move(socket_ptr)));
+    Handshake handshake;
+    boost::asio::read(
+      *socket_ptr,
+      boost::asio::buffer(&handshake, sizeof(handshake)));
+    TcpTuner tuner(socket_ptr->native_handle(), m_options, SO_RCVBUF);
+    std::unique_ptr<RecvSocket> socket(
+      new RecvSocketTcp(std::move(socket_ptr), handshake, tuner));
     return socket;
   }
 
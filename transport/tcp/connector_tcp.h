@@ -15,17 +15,21 @@
 
 namespace lseb {
 
-template<typename T>
-class Connector {
+class ConnectorTcp : public Connector {
 
   boost::asio::io_service m_io_service;
   boost::asio::deadline_timer m_timer;
   std::vector<std::thread> m_threads;
+  TcpOptions m_options;
 
  public:
-  Connector(int credits, int threads = 1):
+  ConnectorTcp(
+    int credits,
+    TcpOptions const& options = TcpOptions(),
+    int threads = 1):
   m_io_service(),
-  m_timer(m_io_service) {
+  m_timer(m_io_service),
+  m_options(options) {
     m_timer.expires_at(boost::posix_time::pos_infin);
     m_timer.async_wait(
       [this](const boost::system::error_code &ec) {std::cout << "TIMER EXPIRED!\n";});
@@ -34,7 +38,7 @@ class Connector {
     }
   }
 
-  ~Connector() {
+  ~ConnectorTcp() {
     m_timer.cancel();
     m_io_service.stop();
     for(auto& t : m_threads) {
@@ -42,7 +46,10 @@ class Connector {
     }
   }
 
-  std::unique_ptr<T> connect(std::string const& hostname, std::string const& port) {
+  std::unique_ptr<SendSocket> connect(
+    std::string const& hostname,
+    std::string const& port,
+    Handshake const& handshake) {
     boost::asio::ip::tcp::resolver resolver(m_io_service);
     boost::asio::ip::tcp::resolver::query query(hostname, port);
     boost::asio::ip::tcp::resolver::iterator iterator = resolver.resolve(query);
@@ -52,6 +59,8 @@ class Connector {
     boost::system::error_code error = boost::asio::error::host_not_found;
     while (error && iterator != end) {
       socket_ptr->close();
+      socket_ptr->open(iterator->endpoint().protocol());
+      set_tcp_buffers(socket_ptr->native_handle(), m_options.buffer_size);
       socket_ptr->connect(*iterator, error);
       if (error == boost::asio::error::connection_refused) {
         throw boost::system::system_error(error);  // Connection refused
@@ -62,7 +71,12 @@ class Connector {
     if (error) {
       throw boost::system::system_error(error);
     }
-    std::unique_ptr<T> socket(new T(std::move(socket_ptr)));
+    boost::asio::write(
+      *socket_ptr,
+      boost::asio::buffer(&handshake, sizeof(handshake)));
+    TcpTuner tuner(socket_ptr->native_handle(), m_options, SO_SNDBUF);
+    std::unique_ptr<SendSocket> socket(
+      new SendSocketTcp(std::move(socket_ptr), tuner));
     return socket;
   }
 };
@@ -6,14 +6,19 @@
 
 namespace lseb {
 
-SendSocket::SendSocket(std::shared_ptr<boost::asio::ip::tcp::socket> socket_ptr)
+SendSocketTcp::SendSocketTcp(
+  std::shared_ptr<boost::asio::ip::tcp::socket> socket_ptr,
+  TcpTuner const& tuner)
     :
       m_socket_ptr(std::move(socket_ptr)),
       m_pending(0),
-      m_is_writing(false) {
+      m_is_writing(false),
+      m_tuner(tuner),
+      m_ready_set(nullptr),
+      m_ready_id(-1) {
 }
 
-std::vector<iovec> SendSocket::pop_completed() {
+std::vector<iovec> SendSocketTcp::pop_completed() {
   std::vector<iovec> vect;
   // Take lock
   boost::mutex::scoped_lock lock(m_mutex);
@@ -22,66 +27,112 @@ std::vector<iovec> SendSocket::pop_completed() {
     m_full_iovec_queue.pop();
     m_pending--;
   }
+  lock.unlock();
+  m_tuner.add(iovec_length(vect));
   return vect;
 }
 
-void SendSocket::async_send(iovec const& iov) {
+// Must be called with the lock taken. All the queued messages (up to a
+// batch) go out in a single gather write.
+void SendSocketTcp::async_send() {
+  // The lengths are sent from a copy that lives until the write completes
+  std::shared_ptr<std::vector<iovec> > p_batch(new std::vector<iovec>);
+  while (!m_free_iovec_queue.empty() && p_batch->size() < tcp_send_batch) {
+    p_batch->push_back(m_free_iovec_queue.front());
+    m_free_iovec_queue.pop();
+  }
   std::vector<boost::asio::const_buffer> buffers;
-  buffers.push_back(boost::asio::buffer(&iov.iov_len, sizeof(iov.iov_len)));
-  buffers.push_back(boost::asio::buffer(iov.iov_base, iov.iov_len));
-  //std::cout << "[" << iov.iov_base << "] async_write...\n";
+  for (auto const& iov : *p_batch) {
+    buffers.push_back(boost::asio::buffer(&iov.iov_len, sizeof(iov.iov_len)));
+    buffers.push_back(boost::asio::buffer(iov.iov_base, iov.iov_len));
+  }
   boost::asio::async_write(
     *m_socket_ptr,
     buffers,
-    [this, iov](boost::system::error_code const& error, size_t byte_transferred) {
+    [this, p_batch](boost::system::error_code const& error, size_t byte_transferred) {
+      // Operations are cancelled when the socket is closed
+      if (error == boost::asio::error::operation_aborted) {
+        return;
+      }
       if(error) {
         std::cout << "Error on async_write: " << boost::system::system_error(error).what() << std::endl;
         throw boost::system::system_error(error);
       }
-      assert(byte_transferred >= sizeof(iov.iov_len));
-      assert(iov.iov_len == byte_transferred - sizeof(iov.iov_len));
-      //std::cout << "[" << iov.iov_base << "] async_write: sent " << byte_transferred << " bytes\n";
+      assert(
+        byte_transferred == iovec_length(*p_batch)
+          + p_batch->size() * sizeof(size_t));
 
         // Take lock
         boost::mutex::scoped_lock lock(m_mutex);
+        for (auto const& iov : *p_batch) {
+          m_full_iovec_queue.push(iov);
+        }
         if(!m_free_iovec_queue.empty()) {
-          iovec iov = m_free_iovec_queue.front();
-          m_free_iovec_queue.pop();
-          async_send(iov);
+          async_send();
         }
         else {
           m_is_writing = false;
         }
-        m_full_iovec_queue.push(iov);
+        if (m_ready_set) {
+          m_ready_set->notify(m_ready_id);
+        }
     });
 }
 
+void SendSocketTcp::post_send(iovec const& iov) {
+  post_send(std::vector<iovec>(1, iov));
+}
 
-void SendSocket::post_send(iovec const& iov) {
+void SendSocketTcp::post_send(std::vector<iovec> const& iov_vect) {
   // Take lock
   boost::mutex::scoped_lock lock(m_mutex);
-  ++m_pending;
-  if (!m_is_writing) {
-    m_is_writing = true;
-    async_send(iov);
-  }
-  else{
+  m_pending += iov_vect.size();
+  for (auto const& iov : iov_vect) {
     m_free_iovec_queue.push(iov);
   }
+  if (!m_is_writing && !m_free_iovec_queue.empty()) {
+    m_is_writing = true;
+    async_send();
+  }
 }
 
-int SendSocket::pending() {
+int SendSocketTcp::pending() {
   boost::mutex::scoped_lock lock(m_mutex);
   return m_pending;
 }
 
-RecvSocket::RecvSocket(std::shared_ptr<boost::asio::ip::tcp::socket> socket_ptr)
+SocketTuning SendSocketTcp::tuning() {
+  return m_tuner.tuning();
+}
+
+bool SendSocketTcp::notify_completions(ReadySet& ready_set, int id) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_ready_set = &ready_set;
+  m_ready_id = id;
+  // Completions arrived before are not lost
+  if (!m_full_iovec_queue.empty()) {
+    m_ready_set->notify(m_ready_id);
+  }
+  return true;
+}
+
+RecvSocketTcp::RecvSocketTcp(
+  std::shared_ptr<boost::asio::ip::tcp::socket> socket_ptr,
+  Handshake const& peer_handshake,
+  TcpTuner const& tuner)
     :
       m_socket_ptr(std::move(socket_ptr)),
-      m_is_reading(false) {
+      m_is_reading(false),
+      m_peer_handshake(peer_handshake),
+      m_tuner(tuner),
+      m_ring_mode(false),
+      m_ring_waiting(false),
+      m_ring_header(0),
+      m_ready_set(nullptr),
+      m_ready_id(-1) {
 }
 
-std::vector<iovec> RecvSocket::pop_completed() {
+std::vector<iovec> RecvSocketTcp::pop_completed() {
   std::vector<iovec> iov_vect;
   // Take lock
   boost::mutex::scoped_lock lock(m_mutex);
@@ -89,22 +140,28 @@ std::vector<iovec> RecvSocket::pop_completed() {
     iov_vect.push_back(m_full_iovec_queue.front());
     m_full_iovec_queue.pop();
   }
+  lock.unlock();
+  m_tuner.add(iovec_length(iov_vect));
   return iov_vect;
 }
 
-void RecvSocket::async_recv(iovec const& iov) {
+void RecvSocketTcp::async_recv(iovec const& iov) {
   std::shared_ptr<iovec> p_iov(new iovec);
   p_iov->iov_base = iov.iov_base;
     boost::array<boost::asio::mutable_buffer, 2> buffers = { boost::asio::buffer(
     &(p_iov->iov_len),
     sizeof(p_iov->iov_len)), boost::asio::buffer(
     boost::asio::buffer(p_iov->iov_base, iov.iov_len)) };
-  //std::cout << "[" << p_iov->iov_base << "] async_read (at least " << sizeof(p_iov->iov_len) << " bytes)...\n";
+  // Read exactly the header: reading more could consume the next message
   boost::asio::async_read(
     *m_socket_ptr,
     buffers,
-    boost::asio::transfer_at_least(sizeof(p_iov->iov_len)),
+    boost::asio::transfer_exactly(sizeof(p_iov->iov_len)),
     [this, p_iov](boost::system::error_code const& error, size_t byte_transferred) {
+      // Operations are cancelled when the socket is closed
+      if (error == boost::asio::error::operation_aborted) {
+        return;
+      }
       if(error) {
         std::cout << "Error on async_read: " << boost::system::system_error(error).what() << std::endl;
         throw boost::system::system_error(error);
@@ -123,6 +180,10 @@ void RecvSocket::async_recv(iovec const& iov) {
         boost::asio::buffer(static_cast<char*>(p_iov->iov_base) + byte_transferred, remain),
         boost::asio::transfer_all(),
         [this, p_iov](boost::system::error_code const& error, size_t byte_transferred) {
+        // Operations are cancelled when the socket is closed
+        if (error == boost::asio::error::operation_aborted) {
+          return;
+        }
         if(error) {
           std::cout << "Error on async_read: " << boost::system::system_error(error).what() << std::endl;
           throw boost::system::system_error(error);
@@ -132,6 +193,9 @@ void RecvSocket::async_recv(iovec const& iov) {
         // Take lock
         boost::mutex::scoped_lock lock(m_mutex);
         m_full_iovec_queue.push(*p_iov);
+        if (m_ready_set) {
+          m_ready_set->notify(m_ready_id);
+        }
         if(!m_free_iovec_queue.empty()){
           iovec iov = m_free_iovec_queue.front();
           m_free_iovec_queue.pop();
@@ -144,9 +208,78 @@ void RecvSocket::async_recv(iovec const& iov) {
     });
 }
 
-void RecvSocket::post_recv(iovec const& iov) {
+void RecvSocketTcp::async_recv_header() {
+  boost::asio::async_read(
+    *m_socket_ptr,
+    boost::asio::buffer(&m_ring_header, sizeof(m_ring_header)),
+    boost::asio::transfer_all(),
+    [this](boost::system::error_code const& error, size_t byte_transferred) {
+      // Operations are cancelled when the socket is closed
+      if (error == boost::asio::error::operation_aborted) {
+        return;
+      }
+      if(error) {
+        std::cout << "Error on async_read: " << boost::system::system_error(error).what() << std::endl;
+        throw boost::system::system_error(error);
+      }
+      assert(m_ring_header > 0);
+      // Take lock
+      boost::mutex::scoped_lock lock(m_mutex);
+      ring_place();
+    });
+}
+
+// Must be called with the lock taken
+void RecvSocketTcp::ring_place() {
+  iovec iov = m_ring_pool.alloc(m_ring_header);
+  if (!iov.iov_base) {
+    // Wait for the release of older messages
+    m_ring_waiting = true;
+    return;
+  }
+  m_ring_waiting = false;
+  boost::asio::async_read(
+    *m_socket_ptr,
+    boost::asio::buffer(iov.iov_base, iov.iov_len),
+    boost::asio::transfer_all(),
+    [this, iov](boost::system::error_code const& error, size_t byte_transferred) {
+      // Operations are cancelled when the socket is closed
+      if (error == boost::asio::error::operation_aborted) {
+        return;
+      }
+      if(error) {
+        std::cout << "Error on async_read: " << boost::system::system_error(error).what() << std::endl;
+        throw boost::system::system_error(error);
+      }
+      // Take lock
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_full_iovec_queue.push(iov);
+      if (m_ready_set) {
+        m_ready_set->notify(m_ready_id);
+      }
+      async_recv_header();
+    });
+}
+
+void RecvSocketTcp::post_recv_ring(void* buffer, size_t size) {
+  // Take lock
+  boost::mutex::scoped_lock lock(m_mutex);
+  assert(!m_is_reading && !m_ring_mode);
+  m_ring_mode = true;
+  m_ring_pool = RingPool(static_cast<unsigned char*>(buffer), size);
+  async_recv_header();
+}
+
+void RecvSocketTcp::post_recv(iovec const& iov) {
   // Take lock
   boost::mutex::scoped_lock lock(m_mutex);
+  if (m_ring_mode) {
+    m_ring_pool.free(iov);
+    if (m_ring_waiting) {
+      ring_place();
+    }
+    return;
+  }
   if (!m_is_reading) {
     m_is_reading = true;
     async_recv(iov);
@@ -156,14 +289,28 @@ void RecvSocket::post_recv(iovec const& iov) {
   }
 }
 
-void RecvSocket::post_recv(std::vector<iovec> const& iov_vect) {
+void RecvSocketTcp::post_recv(std::vector<iovec> const& iov_vect) {
   for (auto const& iov : iov_vect) {
     post_recv(iov);
   }
 }
 
-std::string RecvSocket::peer_hostname() {
+std::string RecvSocketTcp::peer_hostname() {
   return m_socket_ptr->remote_endpoint().address().to_string();
 }
 
+Handshake RecvSocketTcp::peer_handshake() {
+  return m_peer_handshake;
+}
+
+bool RecvSocketTcp::notify_completions(ReadySet& ready_set, int id) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_ready_set = &ready_set;
+  m_ready_id = id;
+  if (!m_full_iovec_queue.empty()) {
+    m_ready_set->notify(m_ready_id);
+  }
+  return true;
+}
+
 }
@@ -8,43 +8,74 @@
 #include <boost/thread.hpp>
 
 #include "common/utility.h"
+#include "common/ring_pool.h"
+
+#include "transport/transport.h"
+#include "transport/tcp/tcp_tuning.h"
 
 namespace lseb {
 
-class SendSocket {
+// Maximum number of messages in a single write (two buffers each)
+static size_t const tcp_send_batch = 64;
+
+class SendSocketTcp : public SendSocket {
   std::shared_ptr<boost::asio::ip::tcp::socket> m_socket_ptr;
   int m_pending;
   boost::mutex m_mutex;
   bool m_is_writing;
   std::queue<iovec> m_free_iovec_queue;
   std::queue<iovec> m_full_iovec_queue;
-  void async_send(iovec const& iov);
+  TcpTuner m_tuner;
+  ReadySet* m_ready_set;
+  int m_ready_id;
+  void async_send();
 
  public:
-  SendSocket(std::shared_ptr<boost::asio::ip::tcp::socket> socket_ptr);
+  SendSocketTcp(
+    std::shared_ptr<boost::asio::ip::tcp::socket> socket_ptr,
+    TcpTuner const& tuner);
   void register_memory(void* buffer, size_t size) {
   }
   std::vector<iovec> pop_completed();
   void post_send(iovec const& iov);
+  void post_send(std::vector<iovec> const& iov_vect);
   int pending();
+  SocketTuning tuning();
+  bool notify_completions(ReadySet& ready_set, int id);
 };
 
-class RecvSocket {
+class RecvSocketTcp : public RecvSocket {
   std::shared_ptr<boost::asio::ip::tcp::socket> m_socket_ptr;
   boost::mutex m_mutex;
   bool m_is_reading;
   std::queue<iovec> m_free_iovec_queue;
   std::queue<iovec> m_full_iovec_queue;
+  Handshake m_peer_handshake;
+  TcpTuner m_tuner;
+  bool m_ring_mode;
+  bool m_ring_waiting;
+  RingPool m_ring_pool;
+  uint64_t m_ring_header;
+  ReadySet* m_ready_set;
+  int m_ready_id;
   void async_recv(iovec const& iov);
+  void async_recv_header();
+  void ring_place();
 
  public:
-  RecvSocket(std::shared_ptr<boost::asio::ip::tcp::socket> socket_ptr);
+  RecvSocketTcp(
+    std::shared_ptr<boost::asio::ip::tcp::socket> socket_ptr,
+    Handshake const& peer_handshake,
+    TcpTuner const& tuner);
   void register_memory(void* buffer, size_t size) {
   }
   std::vector<iovec> pop_completed();
   void post_recv(iovec const& iov);
   void post_recv(std::vector<iovec> const& iov_vect);
+  void post_recv_ring(void* buffer, size_t size);
   std::string peer_hostname();
+  Handshake peer_handshake();
+  bool notify_completions(ReadySet& ready_set, int id);
 };
 
 }
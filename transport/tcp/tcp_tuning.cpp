@@ -0,0 +1,123 @@
+#include "transport/tcp/tcp_tuning.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstring>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+namespace lseb {
+
+namespace {
+
+// Measures are refreshed at most once per period
+double const tuning_period = 1.0;
+
+void set_option(int fd, int level, int name, int value, char const* str) {
+  if (setsockopt(fd, level, name, &value, sizeof(value))) {
+    throw std::runtime_error(
+      "Error on setsockopt(" + std::string(str) + "): "
+        + std::string(strerror(errno)));
+  }
+}
+
+}
+
+double tcp_rtt(int fd) {
+  tcp_info info;
+  socklen_t len = sizeof(info);
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len)) {
+    throw std::runtime_error(
+      "Error on getsockopt(TCP_INFO): " + std::string(strerror(errno)));
+  }
+  return info.tcpi_rtt / 1e6;
+}
+
+void apply_tcp_options(int fd, TcpOptions const& options) {
+  if (options.nodelay) {
+    set_option(fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+  }
+#ifdef TCP_NOTSENT_LOWAT
+  if (options.notsent_lowat) {
+    set_option(
+      fd,
+      IPPROTO_TCP,
+      TCP_NOTSENT_LOWAT,
+      options.notsent_lowat,
+      "TCP_NOTSENT_LOWAT");
+  }
+#endif
+#ifdef SO_MAX_PACING_RATE
+  if (options.pacing_rate) {
+    set_option(
+      fd,
+      SOL_SOCKET,
+      SO_MAX_PACING_RATE,
+      std::min<uint64_t>(options.pacing_rate, 0xffffffffu),
+      "SO_MAX_PACING_RATE");
+  }
+#endif
+}
+
+size_t tcp_buffer_size(
+  double link_speed,
+  double rtt,
+  size_t min_buffer,
+  size_t max_buffer) {
+  if (link_speed <= 0. || rtt <= 0.) {
+    return 0;
+  }
+  double const size = 2 * link_speed * rtt;
+  return std::max<double>(min_buffer, std::min<double>(max_buffer, size));
+}
+
+void set_tcp_buffers(int fd, size_t size) {
+  if (size) {
+    set_option(fd, SOL_SOCKET, SO_SNDBUF, size, "SO_SNDBUF");
+    set_option(fd, SOL_SOCKET, SO_RCVBUF, size, "SO_RCVBUF");
+  }
+}
+
+size_t tcp_buffer(int fd, int name) {
+  int value = 0;
+  socklen_t len = sizeof(value);
+  if (getsockopt(fd, SOL_SOCKET, name, &value, &len)) {
+    throw std::runtime_error(
+      "Error on getsockopt(SO_SNDBUF/SO_RCVBUF): "
+        + std::string(strerror(errno)));
+  }
+  return value;
+}
+
+TcpTuner::TcpTuner(int fd, TcpOptions const& options, int buffer_name)
+    :
+      m_fd(fd),
+      m_buffer_name(buffer_name),
+      m_bytes(0),
+      m_start_time(std::chrono::high_resolution_clock::now()) {
+  apply_tcp_options(m_fd, options);
+  m_tuning.rtt = tcp_rtt(m_fd);
+  m_tuning.buffer_size = tcp_buffer(m_fd, m_buffer_name);
+}
+
+void TcpTuner::add(size_t bytes) {
+  m_bytes += bytes;
+  auto const now = std::chrono::high_resolution_clock::now();
+  double const elapsed_seconds =
+    std::chrono::duration<double>(now - m_start_time).count();
+  if (elapsed_seconds < tuning_period) {
+    return;
+  }
+  m_tuning.rtt = tcp_rtt(m_fd);
+  m_tuning.bandwidth = m_bytes / elapsed_seconds;
+  // The kernel keeps growing the buffers it autotunes
+  m_tuning.buffer_size = tcp_buffer(m_fd, m_buffer_name);
+  m_bytes = 0;
+  m_start_time = now;
+}
+
+}
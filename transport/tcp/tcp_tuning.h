@@ -0,0 +1,55 @@
+#ifndef TRANSPORT_TCP_TCP_TUNING_H
+#define TRANSPORT_TCP_TCP_TUNING_H
+
+#include <chrono>
+
+#include "transport/transport.h"
+
+namespace lseb {
+
+// Smoothed round trip time of a connected socket, in seconds
+double tcp_rtt(int fd);
+
+// Sets the options that do not depend on the measured values
+void apply_tcp_options(int fd, TcpOptions const& options);
+
+// Size of the socket buffers for a link of link_speed (bytes/s) and rtt
+// (seconds): twice the bandwidth-delay product, between min_buffer and
+// max_buffer. Zero if the product is not known, to keep the autotuning of the
+// kernel.
+size_t tcp_buffer_size(
+  double link_speed,
+  double rtt,
+  size_t min_buffer,
+  size_t max_buffer);
+
+// Sets both socket buffers, unless size is zero. It must be called before
+// connect() or listen(), since the window scale is agreed in the handshake and
+// the buffers of the accepted sockets are inherited from the listening one.
+void set_tcp_buffers(int fd, size_t size);
+
+// Value of a socket buffer (SO_SNDBUF or SO_RCVBUF) as applied by the kernel
+size_t tcp_buffer(int fd, int name);
+
+// Applies the options of a connected socket and periodically measures its
+// round trip time, bandwidth and buffer size
+class TcpTuner {
+  int m_fd;
+  int m_buffer_name;
+  SocketTuning m_tuning;
+  size_t m_bytes;
+  std::chrono::high_resolution_clock::time_point m_start_time;
+
+ public:
+  // buffer_name is the buffer reported, SO_SNDBUF or SO_RCVBUF
+  TcpTuner(int fd, TcpOptions const& options, int buffer_name);
+  // Accounts completed bytes and periodically refreshes the measures
+  void add(size_t bytes);
+  SocketTuning tuning() const {
+    return m_tuning;
+  }
+};
+
+}
+
+#endif
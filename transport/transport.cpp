@@ -0,0 +1,85 @@
+#include "transport/transport.h"
+
+#include <stdexcept>
+
+#include <cassert>
+
+#include "transport/tcp/acceptor_tcp.h"
+#include "transport/tcp/connector_tcp.h"
+#include "transport/shm/acceptor_shm.h"
+#include "transport/shm/connector_shm.h"
+#ifdef HAVE_VERBS
+#include "transport/verbs/acceptor_verbs.h"
+#include "transport/verbs/connector_verbs.h"
+#endif
+
+namespace lseb {
+
+TransportType transport_from_string(std::string const& str) {
+  if (str == "TCP")
+    return TransportType::TCP;
+  if (str == "VERBS")
+    return TransportType::VERBS;
+  if (str == "SHM")
+    return TransportType::SHM;
+  throw std::runtime_error("Unknown transport layer: " + str);
+}
+
+std::string transport_to_string(TransportType type) {
+  switch (type) {
+    case TransportType::TCP:
+      return "TCP";
+    case TransportType::VERBS:
+      return "VERBS";
+    case TransportType::SHM:
+      return "SHM";
+  }
+  assert(!"Unknown transport layer");
+  return "";
+}
+
+bool supports_recv_ring(TransportType type) {
+  return type == TransportType::TCP || type == TransportType::SHM;
+}
+
+std::unique_ptr<Connector> make_connector(
+  TransportType type,
+  int credits,
+  TcpOptions const& tcp_options) {
+  switch (type) {
+    case TransportType::TCP:
+      return std::unique_ptr<Connector>(new ConnectorTcp(credits, tcp_options));
+    case TransportType::SHM:
+      return std::unique_ptr<Connector>(new ConnectorShm(credits));
+    case TransportType::VERBS:
+#ifdef HAVE_VERBS
+      return std::unique_ptr<Connector>(new ConnectorVerbs(credits));
+#else
+      break;
+#endif
+  }
+  throw std::runtime_error(
+    "Transport layer not available: " + transport_to_string(type));
+}
+
+std::unique_ptr<Acceptor> make_acceptor(
+  TransportType type,
+  int credits,
+  TcpOptions const& tcp_options) {
+  switch (type) {
+    case TransportType::TCP:
+      return std::unique_ptr<Acceptor>(new AcceptorTcp(credits, tcp_options));
+    case TransportType::SHM:
+      return std::unique_ptr<Acceptor>(new AcceptorShm(credits));
+    case TransportType::VERBS:
+#ifdef HAVE_VERBS
+      return std::unique_ptr<Acceptor>(new AcceptorVerbs(credits));
+#else
+      break;
+#endif
+  }
+  throw std::runtime_error(
+    "Transport layer not available: " + transport_to_string(type));
+}
+
+}
@@ -1,16 +1,139 @@
 #ifndef TRANSPORT_TRANSPORT_H
 #define TRANSPORT_TRANSPORT_H
 
-#ifdef TCP
-#include "transport/tcp/socket_tcp.h"
-#include "transport/tcp/acceptor_tcp.h"
-#include "transport/tcp/connector_tcp.h"
-#elif VERBS
-#include "transport/verbs/socket_verbs.h"
-#include "transport/verbs/acceptor_verbs.h"
-#include "transport/verbs/connector_verbs.h"
-#else
-static_assert(true, "Missing transport layer!");
-#endif
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdexcept>
+
+#include <cstdint>
+
+#include <sys/uio.h>
+
+#include "common/ready_set.h"
+
+namespace lseb {
+
+enum class TransportType {
+  TCP, VERBS, SHM
+};
+
+TransportType transport_from_string(std::string const& str);
+std::string transport_to_string(TransportType type);
+
+// Transports able to place incoming messages back to back in a ring
+bool supports_recv_ring(TransportType type);
+
+// Sent by the connector when a connection is established
+struct Handshake {
+  uint32_t rank;
+  uint32_t credits;
+  uint64_t chunk_size;
+};
+
+// Options of the TCP sockets, see transport/tcp/tcp_tuning.h
+struct TcpOptions {
+  bool nodelay;
+  bool auto_tune;
+  size_t notsent_lowat;  // bytes, 0 keeps the kernel default
+  uint64_t pacing_rate;  // bytes/s, 0 disables pacing
+  double link_speed;  // bytes/s, 0 if unknown
+  size_t buffer_size;  // bytes, 0 keeps the autotuning of the kernel
+  TcpOptions()
+      :
+        nodelay(true),
+        auto_tune(true),
+        notsent_lowat(0),
+        pacing_rate(0),
+        link_speed(0.),
+        buffer_size(0) {
+  }
+};
+
+// Values measured or chosen by the transport, zero when not applicable
+struct SocketTuning {
+  double rtt;  // seconds
+  double bandwidth;  // bytes/s
+  size_t buffer_size;  // bytes
+  SocketTuning()
+      :
+        rtt(0.),
+        bandwidth(0.),
+        buffer_size(0) {
+  }
+};
+
+class SendSocket {
+ public:
+  virtual ~SendSocket() {
+  }
+  virtual void register_memory(void* buffer, size_t size) = 0;
+  virtual std::vector<iovec> pop_completed() = 0;
+  virtual void post_send(iovec const& iov) = 0;
+  // Several messages posted at once (a single work request chain or write)
+  virtual void post_send(std::vector<iovec> const& iov_vect) = 0;
+  virtual int pending() = 0;
+  virtual SocketTuning tuning() {
+    return SocketTuning();
+  }
+  // Notify id in ready_set when new completions are available. Returns false
+  // if the transport progresses only when polled: the socket must then be
+  // polled at every iteration.
+  virtual bool notify_completions(ReadySet& ready_set, int id) {
+    return false;
+  }
+};
+
+class RecvSocket {
+ public:
+  virtual ~RecvSocket() {
+  }
+  virtual void register_memory(void* buffer, size_t size) = 0;
+  virtual std::vector<iovec> pop_completed() = 0;
+  virtual void post_recv(iovec const& iov) = 0;
+  virtual void post_recv(std::vector<iovec> const& iov_vect) = 0;
+  // Place incoming messages back to back in [buffer, buffer + size) instead
+  // of in posted buffers. Completed iovecs are given back, in the same
+  // order, through post_recv.
+  virtual void post_recv_ring(void* buffer, size_t size) {
+    throw std::runtime_error("Receive ring not supported");
+  }
+  virtual std::string peer_hostname() = 0;
+  virtual Handshake peer_handshake() = 0;
+  // See SendSocket::notify_completions
+  virtual bool notify_completions(ReadySet& ready_set, int id) {
+    return false;
+  }
+};
+
+class Connector {
+ public:
+  virtual ~Connector() {
+  }
+  virtual std::unique_ptr<SendSocket> connect(
+    std::string const& hostname,
+    std::string const& port,
+    Handshake const& handshake) = 0;
+};
+
+class Acceptor {
+ public:
+  virtual ~Acceptor() {
+  }
+  virtual void listen(std::string const& hostname, std::string const& port) = 0;
+  virtual std::unique_ptr<RecvSocket> accept() = 0;
+};
+
+std::unique_ptr<Connector> make_connector(
+  TransportType type,
+  int credits,
+  TcpOptions const& tcp_options = TcpOptions());
+std::unique_ptr<Acceptor> make_acceptor(
+  TransportType type,
+  int credits,
+  TcpOptions const& tcp_options = TcpOptions());
+
+}
 
 #endif
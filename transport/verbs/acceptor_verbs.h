@@ -12,8 +12,7 @@
 
 namespace lseb {
 
-template<typename T>
-class Acceptor {
+class AcceptorVerbs : public Acceptor {
 
   int m_credits;
   rdma_cm_id* m_cm_id;
@@ -45,19 +44,19 @@ class Acceptor {
   }
 
  public:
-  Acceptor(int credits)
+  AcceptorVerbs(int credits)
       :
         m_credits(credits),
         m_cm_id(nullptr) {
   }
 
-  ~Acceptor() {
+  ~AcceptorVerbs() {
     // To be filled
   }
 
   void listen(std::string const& hostname, std::string const& port) {
     auto res = create_addr_info(hostname, port);
-    auto attr = T::create_qp_attr(m_credits);
+    auto attr = RecvSocketVerbs::create_qp_attr(m_credits);
 
     int ret = rdma_create_ep(&m_cm_id, res, NULL, &attr);
     destroy_addr_info(res);
@@ -72,13 +71,21 @@ class Acceptor {
     }
   }
 
-  std::unique_ptr<T> accept() {
+  std::unique_ptr<RecvSocket> accept() {
     rdma_cm_id* new_cm_id;
     if (rdma_get_request(m_cm_id, &new_cm_id)) {
       throw std::runtime_error(
         "Error on rdma_get_request: " + std::string(strerror(errno)));
     }
-    std::unique_ptr<T> socket(new T(new_cm_id, m_credits));
+    // The handshake is carried by the private data of the connection request
+    rdma_conn_param const& param = new_cm_id->event->param.conn;
+    if (param.private_data_len < sizeof(Handshake)) {
+      throw std::runtime_error("Error on rdma_get_request: missing handshake");
+    }
+    Handshake handshake;
+    memcpy(&handshake, param.private_data, sizeof(handshake));
+    std::unique_ptr<RecvSocket> socket(
+      new RecvSocketVerbs(new_cm_id, m_credits, handshake));
     return socket;
   }
 
@@ -12,8 +12,7 @@
 
 namespace lseb {
 
-template<typename T>
-class Connector {
+class ConnectorVerbs : public Connector {
 
   int m_credits;
 
@@ -43,18 +42,21 @@ class Connector {
   }
 
  public:
-  Connector(int credits)
+  ConnectorVerbs(int credits)
       :
         m_credits(credits) {
   }
 
-  ~Connector() {
+  ~ConnectorVerbs() {
     // To be filled
   }
 
-  std::unique_ptr<T> connect(std::string const& hostname, std::string const& port) {
+  std::unique_ptr<SendSocket> connect(
+    std::string const& hostname,
+    std::string const& port,
+    Handshake const& handshake) {
     auto res = create_addr_info(hostname, port);
-    auto attr = T::create_qp_attr(m_credits);
+    auto attr = SendSocketVerbs::create_qp_attr(m_credits);
     rdma_cm_id* cm_id;
 
     int ret = rdma_create_ep(&cm_id, res, NULL, &attr);
@@ -64,7 +66,16 @@ class Connector {
         "Error on rdma_create_ep: " + std::string(strerror(errno)));
     }
 
-    if (rdma_connect(cm_id, NULL)) {
+    rdma_conn_param param;
+    memset(&param, 0, sizeof(param));
+    param.private_data = &handshake;
+    param.private_data_len = sizeof(handshake);
+    param.responder_resources = 1;
+    param.initiator_depth = 1;
+    param.retry_count = 7;
+    param.rnr_retry_count = 7;
+
+    if (rdma_connect(cm_id, &param)) {
       rdma_destroy_ep(cm_id);
       if (errno == ECONNREFUSED) {
         throw std::runtime_error(
@@ -74,7 +85,7 @@ class Connector {
           "Error on rdma_connect: " + std::string(strerror(errno)));
       }
     }
-    std::unique_ptr<T> socket(new T(cm_id, m_credits));
+    std::unique_ptr<SendSocket> socket(new SendSocketVerbs(cm_id, m_credits));
     return socket;
   }
 };
@@ -5,18 +5,18 @@
 
 namespace lseb {
 
-SendSocket::SendSocket(rdma_cm_id* cm_id, int credits)
+SendSocketVerbs::SendSocketVerbs(rdma_cm_id* cm_id, int credits)
     :
       m_cm_id(cm_id),
       m_mr(nullptr),
       m_credits(credits) {
 }
 
-SendSocket::~SendSocket() {
+SendSocketVerbs::~SendSocketVerbs() {
   // To be filled
 }
 
-void SendSocket::register_memory(void* buffer, size_t size) {
+void SendSocketVerbs::register_memory(void* buffer, size_t size) {
   m_mr = rdma_reg_msgs(m_cm_id, buffer, size);
   if (!m_mr) {
     throw std::runtime_error(
@@ -24,7 +24,7 @@ void SendSocket::register_memory(void* buffer, size_t size) {
   }
 }
 
-std::vector<iovec> SendSocket::pop_completed() {
+std::vector<iovec> SendSocketVerbs::pop_completed() {
 
   std::vector<ibv_wc> wcs(m_credits);
   int ret = ibv_poll_cq(m_cm_id->send_cq, wcs.size(), &wcs.front());
@@ -51,52 +51,69 @@ std::vector<iovec> SendSocket::pop_completed() {
   return vect;
 }
 
-void SendSocket::post_send(iovec const& iov) {
+void SendSocketVerbs::post_send(iovec const& iov) {
+  post_send(std::vector<iovec>(1, iov));
+}
 
-  ibv_sge sge;
-  sge.addr = reinterpret_cast<uint64_t>(iov.iov_base);
-  sge.length = iov.iov_len;
-  sge.lkey = m_mr->lkey;
+void SendSocketVerbs::post_send(std::vector<iovec> const& iov_vect) {
 
-  ibv_send_wr wr;
-  wr.wr_id = reinterpret_cast<uint64_t>(iov.iov_base);
-  wr.next = nullptr;
-  wr.sg_list = &sge;
-  wr.num_sge = 1;
-  wr.opcode = IBV_WR_SEND;
-  wr.send_flags = 0;
+  std::vector<std::pair<ibv_send_wr, ibv_sge> > wrs(iov_vect.size());
 
-  ibv_send_wr* bad_wr;
-  int ret = ibv_post_send(m_cm_id->qp, &wr, &bad_wr);
-  if (ret) {
-    throw std::runtime_error(
-      "Error on ibv_post_send: " + std::string(strerror(ret)));
+  for (int i = 0; i < wrs.size(); ++i) {
+    iovec const& iov = iov_vect[i];
+    ibv_sge& sge = wrs[i].second;
+    sge.addr = reinterpret_cast<uint64_t>(iov.iov_base);
+    sge.length = iov.iov_len;
+    sge.lkey = m_mr->lkey;
+
+    ibv_send_wr& wr = wrs[i].first;
+    wr.wr_id = reinterpret_cast<uint64_t>(iov.iov_base);
+    wr.next = (i + 1 == wrs.size()) ? nullptr : &(wrs[i + 1].first);
+    wr.sg_list = &sge;
+    wr.num_sge = 1;
+    wr.opcode = IBV_WR_SEND;
+    wr.send_flags = 0;
   }
 
-  auto p = m_wrs_size.insert(
-      std::pair<void*, size_t>(iov.iov_base, iov.iov_len));
-   if (!p.second) {
-     throw std::runtime_error("Error on insert: key element already exists");
-   }
+  if (!wrs.empty()) {
+    ibv_send_wr* bad_wr;
+    int ret = ibv_post_send(m_cm_id->qp, &(wrs.front().first), &bad_wr);
+    if (ret) {
+      throw std::runtime_error(
+        "Error on ibv_post_send: " + std::string(strerror(ret)));
+    }
+  }
+
+  for (auto const& iov : iov_vect) {
+    auto p = m_wrs_size.insert(
+        std::pair<void*, size_t>(iov.iov_base, iov.iov_len));
+    if (!p.second) {
+      throw std::runtime_error("Error on insert: key element already exists");
+    }
+  }
 }
 
-int SendSocket::pending() {
+int SendSocketVerbs::pending() {
   return m_wrs_size.size();
 }
 
-RecvSocket::RecvSocket(rdma_cm_id* cm_id, int credits)
+RecvSocketVerbs::RecvSocketVerbs(
+  rdma_cm_id* cm_id,
+  int credits,
+  Handshake const& peer_handshake)
     :
       m_cm_id(cm_id),
       m_mr(nullptr),
       m_credits(credits),
-      m_init(false) {
+      m_init(false),
+      m_peer_handshake(peer_handshake) {
 }
 
-RecvSocket::~RecvSocket() {
+RecvSocketVerbs::~RecvSocketVerbs() {
   // To be filled
 }
 
-void RecvSocket::register_memory(void* buffer, size_t size) {
+void RecvSocketVerbs::register_memory(void* buffer, size_t size) {
   m_mr = rdma_reg_msgs(m_cm_id, buffer, size);
   if (!m_mr) {
     throw std::runtime_error(
@@ -104,7 +121,7 @@ void RecvSocket::register_memory(void* buffer, size_t size) {
   }
 }
 
-std::vector<iovec> RecvSocket::pop_completed() {
+std::vector<iovec> RecvSocketVerbs::pop_completed() {
   std::vector<ibv_wc> wcs(m_credits);
   int ret = ibv_poll_cq(m_cm_id->recv_cq, wcs.size(), &wcs.front());
   if (ret < 0) {
@@ -126,11 +143,11 @@ std::vector<iovec> RecvSocket::pop_completed() {
   return iov_vect;
 }
 
-void RecvSocket::post_recv(iovec const& iov) {
+void RecvSocketVerbs::post_recv(iovec const& iov) {
   post_recv(std::vector<iovec>(1, iov));
 }
 
-void RecvSocket::post_recv(std::vector<iovec> const& iov_vect) {
+void RecvSocketVerbs::post_recv(std::vector<iovec> const& iov_vect) {
 
   std::vector<std::pair<ibv_recv_wr, ibv_sge> > wrs(iov_vect.size());
 
@@ -166,11 +183,15 @@ void RecvSocket::post_recv(std::vector<iovec> const& iov_vect) {
   }
 }
 
-std::string RecvSocket::peer_hostname() {
+std::string RecvSocketVerbs::peer_hostname() {
   char str[INET_ADDRSTRLEN];
   auto addr = reinterpret_cast<sockaddr_in*>(rdma_get_peer_addr(m_cm_id));
   inet_ntop(AF_INET, &(addr->sin_addr), str, INET_ADDRSTRLEN);
   return str;
 }
 
+Handshake RecvSocketVerbs::peer_handshake() {
+  return m_peer_handshake;
+}
+
 }
@@ -10,20 +10,23 @@
 #include <infiniband/verbs.h>
 #include <rdma/rdma_verbs.h>
 
+#include "transport/transport.h"
+
 namespace lseb {
 
-class SendSocket {
+class SendSocketVerbs : public SendSocket {
   rdma_cm_id* m_cm_id;
   ibv_mr* m_mr;
   int m_credits;
   std::map<void*, size_t> m_wrs_size;
 
  public:
-  SendSocket(rdma_cm_id* cm_id, int credits);
-  ~SendSocket();
+  SendSocketVerbs(rdma_cm_id* cm_id, int credits);
+  ~SendSocketVerbs();
   void register_memory(void* buffer, size_t size);
   std::vector<iovec> pop_completed();
   void post_send(iovec const& iov);
+  void post_send(std::vector<iovec> const& iov_vect);
   int pending();
 
   static ibv_qp_init_attr create_qp_attr(int credits) {
@@ -39,20 +42,25 @@ class SendSocket {
   }
 };
 
-class RecvSocket {
+class RecvSocketVerbs : public RecvSocket {
   rdma_cm_id* m_cm_id;
   ibv_mr* m_mr;
   int m_credits;
   bool m_init;
+  Handshake m_peer_handshake;
 
  public:
-  RecvSocket(rdma_cm_id* cm_id, int credits);
-  ~RecvSocket();
+  RecvSocketVerbs(
+    rdma_cm_id* cm_id,
+    int credits,
+    Handshake const& peer_handshake);
+  ~RecvSocketVerbs();
   void register_memory(void* buffer, size_t size);
   std::vector<iovec> pop_completed();
   void post_recv(iovec const& iov);
   void post_recv(std::vector<iovec> const& iov_vect);
   std::string peer_hostname();
+  Handshake peer_handshake();
 
   static ibv_qp_init_attr create_qp_attr(int credits) {
     ibv_qp_init_attr attr;